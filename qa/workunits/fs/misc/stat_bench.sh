@@ -0,0 +1,57 @@
+#!/usr/bin/env bash
+
+# Measure stat-heavy metadata throughput as the number of concurrent
+# readers grows.  Every lookup/getattr that reaches the MDS is dispatched
+# under mds_lock, so ops/s should be compared against the
+# mds.dispatch_lock_wait and mds.dispatch_time perf counters to see how
+# much of the scaling curve is lost to lock contention.
+#
+# usage: stat_bench.sh [dirs] [files_per_dir] [max_workers]
+
+set -e
+
+dirs=${1:-8}
+files=${2:-2000}
+max_workers=${3:-8}
+
+top=stat_bench.$$
+mkdir $top
+
+for d in $(seq 1 $dirs); do
+	mkdir $top/d$d
+	(cd $top/d$d && seq 1 $files | xargs touch)
+done
+sync
+
+drop_caches() {
+	# force the client to go back to the MDS for every lookup/getattr
+	sync
+	echo 3 | sudo tee /proc/sys/vm/drop_caches > /dev/null
+}
+
+run() {
+	workers=$1
+	drop_caches
+	start=$(date +%s.%N)
+	for w in $(seq 1 $workers); do
+		(
+			for d in $(seq $w $workers $dirs); do
+				find $top/d$d -type f -printf '%s\n' > /dev/null
+			done
+		) &
+	done
+	wait
+	end=$(date +%s.%N)
+	ops=$((dirs * files))
+	echo "workers=$workers ops=$ops" \
+	     "ops/s=$(echo "$ops / ($end - $start)" | bc -l | xargs printf '%.0f')"
+}
+
+workers=1
+while [ $workers -le $max_workers ]; do
+	run $workers
+	workers=$((workers * 2))
+done
+
+rm -rf $top
+echo OK
@@ -0,0 +1,37 @@
+#!/bin/sh -ex
+
+# Compare random write IOPS of a journaled image against a plain image.
+
+POOL=rbd
+IMAGE=test$$
+IMAGE_SIZE=1G
+IO_TOTAL=256M
+
+rbd_bench() {
+    local image=$1
+    local iops_var_name=$2
+
+    # parse `rbd bench` output for string like this:
+    # elapsed:    25  ops:     2560  ops/sec:   100.08  bytes/sec: 409.13 MiB
+    iops=$(rbd bench "${image}" --io-type write --io-size 4K \
+                     --io-pattern rand --io-threads 16 \
+                     --io-total ${IO_TOTAL} --rbd-cache=false |
+               awk '/elapsed:/ {print int($6)}')
+    eval ${iops_var_name}=${iops}
+}
+
+rbd create "${POOL}/${IMAGE}" -s ${IMAGE_SIZE}
+rbd create "${POOL}/${IMAGE}_journal" -s ${IMAGE_SIZE} \
+    --image-feature exclusive-lock,journaling
+
+rbd_bench "${POOL}/${IMAGE}" plain_iops
+rbd_bench "${POOL}/${IMAGE}_journal" journal_iops
+
+echo "plain: ${plain_iops} IOPS, journaling: ${journal_iops} IOPS"
+test "${plain_iops}" -gt 0
+test "${journal_iops}" -gt 0
+
+rbd rm "${POOL}/${IMAGE}_journal"
+rbd rm "${POOL}/${IMAGE}"
+
+echo OK
@@ -474,7 +474,7 @@ void Client::dump_inode(Formatter *f, Inode *in, set<Inode*>& did, bool disconne
   did.insert(in);
   if (in->dir) {
     ldout(cct, 1) << "  dir " << in->dir << " size " << in->dir->dentries.size() << dendl;
-    for (ceph::unordered_map<string, Dentry*>::iterator it = in->dir->dentries.begin();
+    for (auto it = in->dir->dentries.begin();
          it != in->dir->dentries.end();
          ++it) {
       ldout(cct, 1) << "   " << in->ino << " dn " << it->first << " " << it->second << " ref " << it->second->ref << dendl;
@@ -538,6 +538,11 @@ void Client::dump_status(Formatter *f)
     f->dump_stream("inst_str") << inst.name << " " << inst.addr.get_legacy_str();
     f->dump_string("addr_str", inst.addr.get_legacy_str());
     f->dump_int("inode_count", inode_map.size());
+    f->dump_unsigned("cache_bytes", get_cache_bytes());
+    if (!inode_map.empty()) {
+      f->dump_unsigned("cache_bytes_per_inode",
+                       get_cache_bytes() / inode_map.size());
+    }
     f->dump_int("mds_epoch", mdsmap->get_epoch());
     f->dump_int("osd_epoch", osd_epoch);
     f->dump_int("osd_epoch_barrier", cap_epoch_barrier);
@@ -712,25 +717,41 @@ void Client::shutdown()
 // ===================
 // metadata cache stuff
 
+bool Client::is_cache_memory_full(uint64_t releasing) const
+{
+  uint64_t limit = cct->_conf.get_val<Option::size_t>(
+    "client_cache_memory_limit");
+  return limit > 0 && get_cache_bytes() > limit + releasing;
+}
+
 void Client::trim_cache(bool trim_kernel_dcache)
 {
   uint64_t max = cct->_conf->client_cache_size;
-  ldout(cct, 20) << "trim_cache size " << lru.lru_get_size() << " max " << max << dendl;
+  ldout(cct, 20) << "trim_cache size " << lru.lru_get_size() << " max " << max
+                 << " bytes " << get_cache_bytes() << dendl;
+  // inodes dropped along with their dentries are only freed by the next
+  // delay_put_inodes(), so count them as released right away
+  uint64_t releasing = 0;
   unsigned last = 0;
   while (lru.lru_get_size() != last) {
     last = lru.lru_get_size();
 
-    if (!is_unmounting() && lru.lru_get_size() <= max)  break;
+    if (!is_unmounting() && lru.lru_get_size() <= max &&
+        !is_cache_memory_full(releasing))
+      break;
 
     // trim!
     Dentry *dn = static_cast<Dentry*>(lru.lru_get_next_expire());
     if (!dn)
       break;  // done
 
+    if (dn->inode && dn->inode->get_nref() == 2)
+      releasing += sizeof(Inode);  // only held by inode_map and this dentry
     trim_dentry(dn);
   }
 
-  if (trim_kernel_dcache && lru.lru_get_size() > max)
+  if (trim_kernel_dcache && (lru.lru_get_size() > max ||
+                             is_cache_memory_full(releasing)))
     _invalidate_kernel_dcache();
 
   // hose root?
@@ -3259,6 +3280,7 @@ void Client::close_dir(Dir *dir)
   
   delete in->dir;
   in->dir = 0;
+  sub_cache_bytes(sizeof(Dir));
   put_inode(in);               // unpin inode
 }
 
@@ -3272,6 +3294,7 @@ Dentry* Client::link(Dir *dir, const string& name, Inode *in, Dentry *dn)
   if (!dn) {
     // create a new Dentry
     dn = new Dentry(dir, name);
+    add_cache_bytes(dn->get_cache_bytes());
 
     lru.lru_insert_mid(dn);    // mid or top?
 
@@ -3324,6 +3347,7 @@ void Client::unlink(Dentry *dn, bool keepdir, bool keepdentry)
     // unlink from dir
     Dir *dir = dn->dir;
     dn->detach();
+    sub_cache_bytes(dn->get_cache_bytes());
 
     // delete den
     lru.lru_remove(dn);
@@ -4454,7 +4478,7 @@ void Client::_invalidate_kernel_dcache()
 
   if (can_invalidate_dentries) {
     if (dentry_invalidate_cb && root->dir) {
-      for (ceph::unordered_map<string, Dentry*>::iterator p = root->dir->dentries.begin();
+      for (auto p = root->dir->dentries.begin();
          p != root->dir->dentries.end();
          ++p) {
        if (p->second->inode)
@@ -8619,6 +8643,9 @@ int Client::_readdir_get_frag(dir_result_t *dirp)
   req->set_inode(diri.get());
   req->head.args.readdir.frag = fg;
   req->head.args.readdir.flags = CEPH_READDIR_REPLY_BITFLAGS;
+  req->head.args.readdir.max_bytes = std::min<uint64_t>(
+    cct->_conf.get_val<Option::size_t>("client_readdir_max_bytes"),
+    std::numeric_limits<uint32_t>::max());
   if (dirp->last_name.length()) {
     req->path2.set_path(dirp->last_name);
   } else if (dirp->hash_order()) {
@@ -8652,6 +8679,28 @@ struct dentry_off_lt {
   }
 };
 
+uint64_t Client::_readdir_count_missing_caps(Dir *dir, size_t idx, int caps,
+                                             uint64_t max)
+{
+  uint64_t count = 0;
+  for (; idx < dir->readdir_cache.size() && count < max; ++idx) {
+    Dentry *dn = dir->readdir_cache[idx];
+    if (dn->inode == nullptr ||
+        dn->cap_shared_gen != dir->parent_inode->shared_gen) {
+      continue;
+    }
+
+    int mask = caps;
+    if (dn->inode->is_dir()) {
+      mask |= CEPH_STAT_RSTAT;
+    }
+    if (!dn->inode->caps_issued_mask(mask, true)) {
+      ++count;
+    }
+  }
+  return count;
+}
+
 int Client::_readdir_cache_cb(dir_result_t *dirp, add_dirent_cb_t cb, void *p,
 			      int caps, bool getref)
 {
@@ -8667,9 +8716,13 @@ int Client::_readdir_cache_cb(dir_result_t *dirp, add_dirent_cb_t cb, void *p,
     return 0;
   }
 
-  vector<Dentry*>::iterator pd = std::lower_bound(dir->readdir_cache.begin(),
-						  dir->readdir_cache.end(),
-						  dirp->offset, dentry_off_lt());
+  auto pd = std::lower_bound(dir->readdir_cache.begin(),
+			     dir->readdir_cache.end(),
+			     dirp->offset, dentry_off_lt());
+
+  const uint64_t refetch_threshold = cct->_conf.get_val<uint64_t>(
+    "client_readdir_refetch_threshold");
+  bool refetch_checked = (refetch_threshold == 0);
 
   string dn_name;
   while (true) {
@@ -8694,6 +8747,16 @@ int Client::_readdir_cache_cb(dir_result_t *dirp, add_dirent_cb_t cb, void *p,
     if (dn->inode->is_dir()) {
       mask |= CEPH_STAT_RSTAT;
     }
+    if (!refetch_checked && !dn->inode->caps_issued_mask(mask, true)) {
+      // a single readdir from the MDS refreshes the attributes and caps of
+      // every entry, which beats issuing a getattr for each of them
+      refetch_checked = true;
+      if (_readdir_count_missing_caps(dir, idx, caps, refetch_threshold) >=
+            refetch_threshold) {
+        ldout(cct, 10) << " too many entries lack caps, refetching" << dendl;
+        return -CEPHFS_EAGAIN;
+      }
+    }
     int r = _getattr(dn->inode, mask, dirp->perms);
     if (r < 0)
       return r;
@@ -9905,7 +9968,8 @@ retry:
 
   if (!conf->client_debug_force_sync_read &&
       conf->client_oc &&
-      (have & (CEPH_CAP_FILE_CACHE | CEPH_CAP_FILE_LAZYIO))) {
+      (have & (CEPH_CAP_FILE_CACHE | CEPH_CAP_FILE_LAZYIO)) &&
+      !_should_read_direct(f, offset, size)) {
 
     if (f->flags & O_RSYNC) {
       _flush_range(in, offset, size);
@@ -9944,6 +10008,7 @@ retry:
 
 success:
   ceph_assert(rc >= 0);
+  f->last_read_end = start_pos + rc;
   if (movepos) {
     // adjust fd pos
     f->pos = start_pos + rc;
@@ -10050,6 +10115,33 @@ int Client::_read_async(Fh *f, uint64_t off, uint64_t len, bufferlist *bl)
   return r;
 }
 
+bool Client::_should_read_direct(Fh *f, uint64_t off, uint64_t len)
+{
+  ceph_assert(ceph_mutex_is_locked_by_me(client_lock));
+
+  uint64_t min_bytes = cct->_conf.get_val<Option::size_t>(
+    "client_direct_read_min_bytes");
+  if (min_bytes == 0 || len < min_bytes) {
+    return false;
+  }
+
+  // only streaming readers skip the cache -- anyone else may benefit
+  // from what is already cached or read ahead
+  if (off != f->last_read_end) {
+    return false;
+  }
+
+  // buffered writes have to be read back through the cache
+  Inode *in = f->inode.get();
+  if (objectcacher->set_is_dirty_or_committing(&in->oset)) {
+    return false;
+  }
+
+  ldout(cct, 10) << __func__ << " " << *in << " " << off << "~" << len
+                 << dendl;
+  return true;
+}
+
 int Client::_read_sync(Fh *f, uint64_t off, uint64_t len, bufferlist *bl,
 		       bool *checkeof)
 {
@@ -10123,6 +10215,39 @@ int Client::_read_sync(Fh *f, uint64_t off, uint64_t len, bufferlist *bl,
   return read;
 }
 
+static loff_t iov_total_len(const struct iovec *iov, unsigned iovcnt)
+{
+  loff_t totallen = 0;
+  for (unsigned i = 0; i < iovcnt; i++) {
+    totallen += iov[i].iov_len;
+  }
+  return totallen;
+}
+
+/*
+ * Copy the first @size bytes of the caller's data into a fresh buffer
+ * (since our write may be resub, async).  This only touches the caller's
+ * memory, so callers do it before taking client_lock; _write() must not
+ * drop the lock between picking the offset and applying the write.
+ */
+static bufferlist copy_write_data(const char *buf, const struct iovec *iov,
+                                  int iovcnt, uint64_t size)
+{
+  bufferlist bl;
+  if (buf) {
+    if (size > 0)
+      bl.append(buf, size);
+  } else if (iov) {
+    for (int i = 0; i < iovcnt && bl.length() < size; i++) {
+      auto len = std::min<uint64_t>(iov[i].iov_len, size - bl.length());
+      if (len > 0) {
+        bl.append((const char *)iov[i].iov_base, len);
+      }
+    }
+  }
+  return bl;
+}
+
 int Client::write(int fd, const char *buf, loff_t size, loff_t offset) 
 {
   RWRef_t mref_reader(mount_state, CLIENT_MOUNTING);
@@ -10134,6 +10259,12 @@ int Client::write(int fd, const char *buf, loff_t size, loff_t offset)
   tout(cct) << size << std::endl;
   tout(cct) << offset << std::endl;
 
+  if (size < 0)
+    return -CEPHFS_EINVAL;
+  /* We can't return bytes written larger than INT_MAX, clamp size to that */
+  size = std::min(size, (loff_t)INT_MAX);
+  bufferlist bl = copy_write_data(buf, nullptr, 0, size);
+
   std::scoped_lock lock(client_lock);
   Fh *fh = get_filehandle(fd);
   if (!fh)
@@ -10142,9 +10273,7 @@ int Client::write(int fd, const char *buf, loff_t size, loff_t offset)
   if (fh->flags & O_PATH)
     return -CEPHFS_EBADF;
 #endif
-  /* We can't return bytes written larger than INT_MAX, clamp size to that */
-  size = std::min(size, (loff_t)INT_MAX);
-  int r = _write(fh, offset, size, buf, NULL, false);
+  int r = _write(fh, offset, std::move(bl));
   ldout(cct, 3) << "write(" << fd << ", \"...\", " << size << ", " << offset << ") = " << r << dendl;
   return r;
 }
@@ -10158,7 +10287,8 @@ int Client::pwritev(int fd, const struct iovec *iov, int iovcnt, int64_t offset)
 
 int64_t Client::_preadv_pwritev_locked(Fh *fh, const struct iovec *iov,
                                        unsigned iovcnt, int64_t offset,
-                                       bool write, bool clamp_to_int)
+                                       bool write, bool clamp_to_int,
+                                       bufferlist&& write_bl)
 {
     ceph_assert(ceph_mutex_is_locked_by_me(client_lock));
 
@@ -10166,10 +10296,7 @@ int64_t Client::_preadv_pwritev_locked(Fh *fh, const struct iovec *iov,
     if (fh->flags & O_PATH)
         return -CEPHFS_EBADF;
 #endif
-    loff_t totallen = 0;
-    for (unsigned i = 0; i < iovcnt; i++) {
-        totallen += iov[i].iov_len;
-    }
+    loff_t totallen = iov_total_len(iov, iovcnt);
 
     /*
      * Some of the API functions take 64-bit size values, but only return
@@ -10180,7 +10307,9 @@ int64_t Client::_preadv_pwritev_locked(Fh *fh, const struct iovec *iov,
       totallen = std::min(totallen, (loff_t)INT_MAX);
     }
     if (write) {
-        int64_t w = _write(fh, offset, totallen, NULL, iov, iovcnt);
+        // the payload was copied by the caller before taking client_lock
+        ceph_assert(write_bl.length() == (uint64_t)totallen);
+        int64_t w = _write(fh, offset, std::move(write_bl));
         ldout(cct, 3) << "pwritev(" << fh << ", \"...\", " << totallen << ", " << offset << ") = " << w << dendl;
         return w;
     } else {
@@ -10216,18 +10345,26 @@ int Client::_preadv_pwritev(int fd, const struct iovec *iov, unsigned iovcnt, in
     tout(cct) << fd << std::endl;
     tout(cct) << offset << std::endl;
 
+    bufferlist write_bl;
+    if (write) {
+      write_bl = copy_write_data(nullptr, iov, iovcnt,
+                                 std::min(iov_total_len(iov, iovcnt),
+                                          (loff_t)INT_MAX));
+    }
+
     std::scoped_lock cl(client_lock);
     Fh *fh = get_filehandle(fd);
     if (!fh)
       return -CEPHFS_EBADF;
-    return _preadv_pwritev_locked(fh, iov, iovcnt, offset, write, true);
+    return _preadv_pwritev_locked(fh, iov, iovcnt, offset, write, true,
+                                  std::move(write_bl));
 }
 
-int64_t Client::_write(Fh *f, int64_t offset, uint64_t size, const char *buf,
-	                const struct iovec *iov, int iovcnt)
+int64_t Client::_write(Fh *f, int64_t offset, bufferlist&& bl)
 {
   ceph_assert(ceph_mutex_is_locked_by_me(client_lock));
 
+  uint64_t size = bl.length();
   uint64_t fpos = 0;
 
   if ((uint64_t)(offset+size) > mdsmap->get_max_filesize()) //too large!
@@ -10286,19 +10423,6 @@ int64_t Client::_write(Fh *f, int64_t offset, uint64_t size, const char *buf,
     ceph_assert(in->inline_version > 0);
   }
 
-  // copy into fresh buffer (since our write may be resub, async)
-  bufferlist bl;
-  if (buf) {
-    if (size > 0)
-      bl.append(buf, size);
-  } else if (iov){
-    for (int i = 0; i < iovcnt; i++) {
-      if (iov[i].iov_len > 0) {
-        bl.append((const char *)iov[i].iov_base, iov[i].iov_len);
-      }
-    }
-  }
-
   utime_t lat;
   uint64_t totalwritten;
   int want, have;
@@ -14365,11 +14489,14 @@ int Client::ll_write(Fh *fh, loff_t off, loff_t len, const char *data)
   if (!mref_reader.is_state_satisfied())
     return -CEPHFS_ENOTCONN;
 
+  if (len < 0)
+    return -CEPHFS_EINVAL;
   /* We can't return bytes written larger than INT_MAX, clamp len to that */
   len = std::min(len, (loff_t)INT_MAX);
+  bufferlist bl = copy_write_data(data, nullptr, 0, len);
   std::scoped_lock lock(client_lock);
 
-  int r = _write(fh, off, len, data, NULL, 0);
+  int r = _write(fh, off, std::move(bl));
   ldout(cct, 3) << "ll_write " << fh << " " << off << "~" << len << " = " << r
 		<< dendl;
   return r;
@@ -14381,8 +14508,11 @@ int64_t Client::ll_writev(struct Fh *fh, const struct iovec *iov, int iovcnt, in
   if (!mref_reader.is_state_satisfied())
     return -CEPHFS_ENOTCONN;
 
+  bufferlist write_bl = copy_write_data(nullptr, iov, iovcnt,
+                                        iov_total_len(iov, iovcnt));
   std::scoped_lock cl(client_lock);
-  return _preadv_pwritev_locked(fh, iov, iovcnt, off, true, false);
+  return _preadv_pwritev_locked(fh, iov, iovcnt, off, true, false,
+                                std::move(write_bl));
 }
 
 int64_t Client::ll_readv(struct Fh *fh, const struct iovec *iov, int iovcnt, int64_t off)
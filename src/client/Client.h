@@ -42,6 +42,7 @@
 #include "MetaSession.h"
 #include "UserPerm.h"
 
+#include <atomic>
 #include <fstream>
 #include <map>
 #include <memory>
@@ -817,6 +818,15 @@ public:
   void dec_dentry_nr() {
     --dentry_nr;
   }
+  void add_cache_bytes(uint64_t bytes) {
+    cache_bytes += bytes;
+  }
+  void sub_cache_bytes(uint64_t bytes) {
+    cache_bytes -= bytes;
+  }
+  uint64_t get_cache_bytes() const {
+    return cache_bytes;
+  }
   void dlease_hit() {
     ++dlease_hits;
   }
@@ -1031,6 +1041,7 @@ protected:
   void touch_dn(Dentry *dn);
 
   // trim cache.
+  bool is_cache_memory_full(uint64_t releasing=0) const;
   void trim_cache(bool trim_kernel_dcache=false);
   void trim_cache_for_reconnect(MetaSession *s);
   void trim_dentry(Dentry *dn);
@@ -1269,6 +1280,8 @@ private:
   void _readdir_next_frag(dir_result_t *dirp);
   void _readdir_rechoose_frag(dir_result_t *dirp);
   int _readdir_get_frag(dir_result_t *dirp);
+  uint64_t _readdir_count_missing_caps(Dir *dir, size_t idx, int caps,
+                                       uint64_t max);
   int _readdir_cache_cb(dir_result_t *dirp, add_dirent_cb_t cb, void *p, int caps, bool getref);
   void _closedir(dir_result_t *dirp);
 
@@ -1286,6 +1299,7 @@ private:
 
   int _do_remount(bool retry_on_error);
 
+  bool _should_read_direct(Fh *f, uint64_t off, uint64_t len);
   int _read_sync(Fh *f, uint64_t off, uint64_t len, bufferlist *bl, bool *checkeof);
   int _read_async(Fh *f, uint64_t off, uint64_t len, bufferlist *bl);
 
@@ -1352,11 +1366,11 @@ private:
 
   loff_t _lseek(Fh *fh, loff_t offset, int whence);
   int64_t _read(Fh *fh, int64_t offset, uint64_t size, bufferlist *bl);
-  int64_t _write(Fh *fh, int64_t offset, uint64_t size, const char *buf,
-          const struct iovec *iov, int iovcnt);
+  int64_t _write(Fh *fh, int64_t offset, bufferlist&& bl);
   int64_t _preadv_pwritev_locked(Fh *fh, const struct iovec *iov,
                                  unsigned iovcnt, int64_t offset,
-                                 bool write, bool clamp_to_int);
+                                 bool write, bool clamp_to_int,
+                                 bufferlist&& write_bl = bufferlist());
   int _preadv_pwritev(int fd, const struct iovec *iov, unsigned iovcnt,
                       int64_t offset, bool write);
   int _flush(Fh *fh);
@@ -1546,6 +1560,10 @@ private:
   epoch_t reclaim_osd_epoch = 0;
   entity_addrvec_t reclaim_target_addrs;
 
+  // memory held by this instance's cached inodes, dentries and dirs;
+  // atomic so that it can be sampled without client_lock
+  std::atomic<uint64_t> cache_bytes{0};
+
   // dentry lease metrics
   uint64_t dentry_nr = 0;
   uint64_t dlease_hits = 0;
@@ -31,3 +31,5 @@ std::ostream &operator<<(std::ostream &oss, const Dentry &dn)
 {
   return oss << dn.dir->parent_inode->vino() << "[\"" << dn.name << "\"]";
 }
+
+MEMPOOL_DEFINE_OBJECT_FACTORY(Dentry, client_dentry, client_cache);
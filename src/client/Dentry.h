@@ -2,6 +2,7 @@
 #define CEPH_CLIENT_DENTRY_H
 
 #include "include/lru.h"
+#include "include/mempool.h"
 #include "include/xlist.h"
 
 #include "mds/mdstypes.h"
@@ -77,15 +78,25 @@ public:
     dir = nullptr;
   }
 
+  // memory charged to the client cache: the dentry, its name and its
+  // slot in the parent's dentry map
+  size_t get_cache_bytes() const {
+    return sizeof(Dentry) + name.size() +
+           sizeof(decltype(Dir::dentries)::value_type);
+  }
+
   void dump(Formatter *f) const;
   friend std::ostream &operator<<(std::ostream &oss, const Dentry &Dentry);
 
+  MEMPOOL_CLASS_HELPERS();
+
   Dir	   *dir;
   const std::string name;
   InodeRef inode;
+  // 32-bit members are paired up to avoid padding
   int	   ref = 1; // 1 if there's a dir beneath me.
-  int64_t offset = 0;
   mds_rank_t lease_mds = -1;
+  int64_t offset = 0;
   utime_t lease_ttl;
   uint64_t lease_gen = 0;
   ceph_seq_t lease_seq = 0;
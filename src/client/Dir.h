@@ -2,18 +2,21 @@
 #define CEPH_CLIENT_DIR_H
 
 #include <string>
-#include <vector>
+
+#include "include/mempool.h"
 
 class Dentry;
 struct Inode;
 
 class Dir {
  public:
+  MEMPOOL_CLASS_HELPERS();
+
   Inode    *parent_inode;  // my inode
-  ceph::unordered_map<std::string, Dentry*> dentries;
+  mempool::client_cache::unordered_map<std::string, Dentry*> dentries;
   unsigned num_null_dentries = 0;
 
-  std::vector<Dentry*> readdir_cache;
+  mempool::client_cache::vector<Dentry*> readdir_cache;
 
   explicit Dir(Inode* in) { parent_inode = in; }
 
@@ -26,6 +26,7 @@ struct Fh {
   UserPerm actor_perms; // perms I opened the file with
 
   Readahead readahead;
+  uint64_t last_read_end = 0; // used to detect streaming readers
 
   // file lock
   std::unique_ptr<ceph_lock_state_t> fcntl_locks;
@@ -18,8 +18,18 @@ using std::oct;
 using std::ostream;
 using std::string;
 
+Inode::Inode(Client *c, vinodeno_t vino, file_layout_t *newlayout)
+  : client(c), ino(vino.ino), snapid(vino.snapid), delay_cap_item(this),
+    dirty_cap_item(this), flushing_cap_item(this), snaprealm_item(this),
+    oset((void *)this, newlayout->pool_id, this->ino)
+{
+  client->add_cache_bytes(sizeof(Inode));
+}
+
 Inode::~Inode()
 {
+  client->sub_cache_bytes(sizeof(Inode));
+
   delay_cap_item.remove_myself();
   dirty_cap_item.remove_myself(); 
   snaprealm_item.remove_myself();
@@ -382,6 +392,7 @@ Dir *Inode::open_dir()
 {
   if (!dir) {
     dir = new Dir(this);
+    client->add_cache_bytes(sizeof(Dir));
     lsubdout(client->cct, client, 15) << "open_dir " << dir << " on " << this << dendl;
     ceph_assert(dentries.size() < 2); // dirs can't be hard-linked
     if (!dentries.empty())
@@ -795,4 +806,5 @@ void Inode::mark_caps_clean()
   dirty_cap_item.remove_myself();
 }
 
-
+MEMPOOL_DEFINE_OBJECT_FACTORY(Inode, client_inode, client_cache);
+MEMPOOL_DEFINE_OBJECT_FACTORY(Dir, client_dir, client_cache);
@@ -8,6 +8,7 @@
 
 #include "include/compat.h"
 #include "include/ceph_assert.h"
+#include "include/mempool.h"
 #include "include/types.h"
 #include "include/xlist.h"
 
@@ -115,6 +116,8 @@ struct CapSnap {
 #define I_ERROR_FILELOCK	(1 << 5)
 
 struct Inode : RefCountedObject {
+  MEMPOOL_CLASS_HELPERS();
+
   Client *client;
 
   // -- the actual inode --
@@ -281,10 +284,7 @@ struct Inode : RefCountedObject {
   mds_rank_t dir_pin = MDS_RANK_NONE;
 
   Inode() = delete;
-  Inode(Client *c, vinodeno_t vino, file_layout_t *newlayout)
-    : client(c), ino(vino.ino), snapid(vino.snapid), delay_cap_item(this),
-      dirty_cap_item(this), flushing_cap_item(this), snaprealm_item(this),
-      oset((void *)this, newlayout->pool_id, this->ino) {}
+  Inode(Client *c, vinodeno_t vino, file_layout_t *newlayout);
   ~Inode();
 
   vinodeno_t vino() const { return vinodeno_t(ino, snapid); }
@@ -11,12 +11,9 @@ Readahead::Readahead()
     m_readahead_min_bytes(0),
     m_readahead_max_bytes(NO_LIMIT),
     m_alignments(),
-    m_nr_consec_read(0),
-    m_consec_read_bytes(0),
-    m_last_pos(0),
-    m_readahead_pos(0),
-    m_readahead_trigger_pos(0),
-    m_readahead_size(0),
+    m_streams(1),
+    m_cur_stream(0),
+    m_tick(0),
     m_pending(0) {
 }
 
@@ -28,7 +25,8 @@ Readahead::extent_t Readahead::update(const vector<extent_t>& extents, uint64_t
   for (vector<extent_t>::const_iterator p = extents.begin(); p != extents.end(); ++p) {
     _observe_read(p->first, p->second);
   }
-  if (m_readahead_pos >= limit|| m_last_pos >= limit) {
+  const stream_t& stream = m_streams[m_cur_stream];
+  if (stream.readahead_pos >= limit || stream.last_pos >= limit) {
     m_lock.unlock();
     return extent_t(0, 0);
   }
@@ -40,7 +38,8 @@ Readahead::extent_t Readahead::update(const vector<extent_t>& extents, uint64_t
 Readahead::extent_t Readahead::update(uint64_t offset, uint64_t length, uint64_t limit) {
   m_lock.lock();
   _observe_read(offset, length);
-  if (m_readahead_pos >= limit || m_last_pos >= limit) {
+  const stream_t& stream = m_streams[m_cur_stream];
+  if (stream.readahead_pos >= limit || stream.last_pos >= limit) {
     m_lock.unlock();
     return extent_t(0, 0);
   }
@@ -50,41 +49,66 @@ Readahead::extent_t Readahead::update(uint64_t offset, uint64_t length, uint64_t
 }
 
 void Readahead::_observe_read(uint64_t offset, uint64_t length) {
-  if (offset == m_last_pos) {
-    m_nr_consec_read++;
-    m_consec_read_bytes += length;
+  size_t idx = m_streams.size();
+  for (size_t i = 0; i < m_streams.size(); ++i) {
+    if (m_streams[i].last_pos == offset) {
+      idx = i;
+      break;
+    }
+  }
+
+  if (idx < m_streams.size()) {
+    stream_t& stream = m_streams[idx];
+    stream.nr_consec_read++;
+    stream.consec_read_bytes += length;
+    if (stream.readahead_size > 0 && offset < stream.readahead_pos) {
+      m_stats.hit_bytes += std::min(offset + length, stream.readahead_pos) -
+	offset;
+    }
   } else {
-    m_nr_consec_read = 0;
-    m_consec_read_bytes = 0;
-    m_readahead_trigger_pos = 0;
-    m_readahead_size = 0;
-    m_readahead_pos = 0;
+    // start a new stream in place of the least recently used one
+    idx = 0;
+    for (size_t i = 1; i < m_streams.size(); ++i) {
+      if (m_streams[i].last_used < m_streams[idx].last_used) {
+	idx = i;
+      }
+    }
+    stream_t& stream = m_streams[idx];
+    if (stream.readahead_pos > stream.last_pos) {
+      m_stats.wasted_bytes += stream.readahead_pos - stream.last_pos;
+    }
+    stream = stream_t();
   }
-  m_last_pos = offset + length;
+
+  stream_t& stream = m_streams[idx];
+  stream.last_pos = offset + length;
+  stream.last_used = ++m_tick;
+  m_cur_stream = idx;
 }
 
 Readahead::extent_t Readahead::_compute_readahead(uint64_t limit) {
+  stream_t& stream = m_streams[m_cur_stream];
   uint64_t readahead_offset = 0;
   uint64_t readahead_length = 0;
-  if (m_nr_consec_read >= m_trigger_requests) {
+  if (stream.nr_consec_read >= m_trigger_requests) {
     // currently reading sequentially
-    if (m_last_pos >= m_readahead_trigger_pos) {
+    if (stream.last_pos >= stream.readahead_trigger_pos) {
       // need to read ahead
-      if (m_readahead_size == 0) {
+      if (stream.readahead_size == 0) {
 	// initial readahead trigger
-	m_readahead_size = m_consec_read_bytes;
-	m_readahead_pos = m_last_pos;
+	stream.readahead_size = stream.consec_read_bytes;
+	stream.readahead_pos = stream.last_pos;
       } else {
 	// continuing readahead trigger
-	m_readahead_size *= 2;
-	if (m_last_pos > m_readahead_pos) {
-	  m_readahead_pos = m_last_pos;
+	stream.readahead_size *= 2;
+	if (stream.last_pos > stream.readahead_pos) {
+	  stream.readahead_pos = stream.last_pos;
 	}
       }
-      m_readahead_size = std::max(m_readahead_size, m_readahead_min_bytes);
-      m_readahead_size = std::min(m_readahead_size, m_readahead_max_bytes);
-      readahead_offset = m_readahead_pos;
-      readahead_length = m_readahead_size;
+      stream.readahead_size = std::max(stream.readahead_size, m_readahead_min_bytes);
+      stream.readahead_size = std::min(stream.readahead_size, m_readahead_max_bytes);
+      readahead_offset = stream.readahead_pos;
+      readahead_length = stream.readahead_size;
 
       // Snap to the first alignment possible
       uint64_t readahead_end = readahead_offset + readahead_length;
@@ -106,15 +130,15 @@ Readahead::extent_t Readahead::_compute_readahead(uint64_t limit) {
 	  readahead_length = align_next - readahead_offset;
 	  break;
 	}
-	// Note that m_readahead_size should remain unadjusted.
+	// Note that stream.readahead_size should remain unadjusted.
       }
 
-      if (m_readahead_pos + readahead_length > limit) {
-	readahead_length = limit - m_readahead_pos;
+      if (stream.readahead_pos + readahead_length > limit) {
+	readahead_length = limit - stream.readahead_pos;
       }
 
-      m_readahead_trigger_pos = m_readahead_pos + readahead_length / 2;
-      m_readahead_pos += readahead_length;
+      stream.readahead_trigger_pos = stream.readahead_pos + readahead_length / 2;
+      stream.readahead_pos += readahead_length;
     }
   }
   return extent_t(readahead_offset, readahead_length);
@@ -189,6 +213,21 @@ void Readahead::set_max_readahead_size(uint64_t max_readahead_size) {
   m_lock.unlock();
 }
 
+void Readahead::set_max_streams(unsigned max_streams) {
+  std::lock_guard lock(m_lock);
+  m_streams.resize(std::max(max_streams, 1u));
+  if (m_cur_stream >= m_streams.size()) {
+    m_cur_stream = 0;
+  }
+}
+
+Readahead::stats_t Readahead::consume_stats() {
+  std::lock_guard lock(m_lock);
+  stats_t stats = m_stats;
+  m_stats = stats_t();
+  return stats;
+}
+
 void Readahead::set_alignments(const vector<uint64_t> &alignments) {
   m_lock.lock();
   m_alignments = alignments;
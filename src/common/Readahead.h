@@ -100,6 +100,25 @@ public:
    */
   void set_max_readahead_size(uint64_t max_readahead_size);
 
+  /**
+     Sets the number of independent sequential streams that are tracked.
+     A read that does not continue any tracked stream replaces the least
+     recently used one.  Defaults to 1.
+   */
+  void set_max_streams(unsigned max_streams);
+
+  /// Bytes of readahead consumed by reads and bytes discarded unread
+  struct stats_t {
+    uint64_t hit_bytes = 0;
+    uint64_t wasted_bytes = 0;
+  };
+
+  /**
+     Returns the readahead hit/waste counts accumulated since the last call
+     and resets them.
+   */
+  stats_t consume_stats();
+
   /**
      Sets the alignment units.
      If the end point of a readahead request can be aligned to an alignment unit
@@ -109,6 +128,30 @@ public:
   void set_alignments(const std::vector<uint64_t> &alignments);
 
 private:
+  /// State of a single sequential read stream
+  struct stream_t {
+    /// Number of consecutive read requests in the stream
+    int nr_consec_read = 0;
+
+    /// Number of bytes read in the stream
+    uint64_t consec_read_bytes = 0;
+
+    /// Position of the read stream
+    uint64_t last_pos = 0;
+
+    /// Position of the readahead stream
+    uint64_t readahead_pos = 0;
+
+    /// When readahead is already triggered and the read stream crosses this point, readahead is continued
+    uint64_t readahead_trigger_pos = 0;
+
+    /// Size of the next readahead request (barring changes due to alignment, etc.)
+    uint64_t readahead_size = 0;
+
+    /// Sequence number of the last read, for LRU replacement
+    uint64_t last_used = 0;
+  };
+
   /**
      Records that a read request has been received.
      m_lock must be held while calling.
@@ -136,23 +179,17 @@ private:
   /// Held while reading/modifying any state except m_pending
   ceph::mutex m_lock = ceph::make_mutex("Readahead::m_lock");
 
-  /// Number of consecutive read requests in the current sequential stream
-  int m_nr_consec_read;
-
-  /// Number of bytes read in the current sequenial stream
-  uint64_t m_consec_read_bytes;
-
-  /// Position of the read stream
-  uint64_t m_last_pos;
+  /// Tracked sequential streams (always at least one)
+  std::vector<stream_t> m_streams;
 
-  /// Position of the readahead stream
-  uint64_t m_readahead_pos;
+  /// Index of the stream that received the most recent read
+  size_t m_cur_stream;
 
-  /// When readahead is already triggered and the read stream crosses this point, readahead is continued
-  uint64_t m_readahead_trigger_pos;
+  /// Sequence number handed out to the most recently used stream
+  uint64_t m_tick;
 
-  /// Size of the next readahead request (barring changes due to alignment, etc.)
-  uint64_t m_readahead_size;
+  /// Readahead hit/waste counts since the last consume_stats()
+  stats_t m_stats;
 
   /// Number of pending readahead requests, as determined by inc_pending() and dec_pending()
   int m_pending;
@@ -72,6 +72,9 @@ bool ObjectRecorder::append(AppendBuffers &&append_buffers) {
 
   ceph::ref_t<FutureImpl> last_flushed_future;
   auto flush_handler = get_flush_handler();
+  if (m_pending_buffers.empty() && !append_buffers.empty()) {
+    m_pending_time = ceph_clock_now();
+  }
   for (auto& append_buffer : append_buffers) {
     ldout(m_cct, 20) << *append_buffer.first << ", "
                      << "size=" << append_buffer.second.length() << dendl;
@@ -177,12 +180,22 @@ bool ObjectRecorder::close() {
   return true;
 }
 
-void ObjectRecorder::handle_append_flushed(uint64_t tid, int r) {
+void ObjectRecorder::handle_append_flushed(uint64_t tid, int r,
+                                           utime_t start_time) {
   ldout(m_cct, 20) << "tid=" << tid << ", r=" << r << dendl;
 
   std::unique_lock locker{*m_lock};
   ++m_in_flight_callbacks;
 
+  if (r >= 0) {
+    double latency = ceph_clock_now() - start_time;
+    if (m_avg_append_latency == 0) {
+      m_avg_append_latency = latency;
+    } else {
+      m_avg_append_latency = (7 * m_avg_append_latency + latency) / 8;
+    }
+  }
+
   auto tid_iter = m_in_flight_tids.find(tid);
   ceph_assert(tid_iter != m_in_flight_tids.end());
   m_in_flight_tids.erase(tid_iter);
@@ -297,6 +310,20 @@ bool ObjectRecorder::send_appends(bool force, ceph::ref_t<FutureImpl> flush_futu
     if (!force && max_in_flight_appends == 0) {
       ldout(m_cct, 20) << "attempting to batch AIO appends" << dendl;
       max_in_flight_appends = 1;
+
+      // group commit: appends normally accumulate while the previous batch
+      // is in flight. If the pending batch has already waited for half of
+      // the typical append round-trip, pipeline it instead of waiting for
+      // the in-flight appends to complete.
+      auto in_flight = static_cast<int32_t>(m_in_flight_tids.size());
+      if (in_flight > 0 && in_flight < MAX_PIPELINED_BATCHES &&
+          m_avg_append_latency > 0 &&
+          ceph_clock_now() - m_pending_time >= m_avg_append_latency / 2) {
+        ldout(m_cct, 20) << "pipelining batched appends: "
+                         << "in_flight=" << in_flight << ", "
+                         << "avg_latency=" << m_avg_append_latency << dendl;
+        max_in_flight_appends = in_flight + 1;
+      }
     }
   } else if (max_in_flight_appends < 0) {
     max_in_flight_appends = 0;
@@ -352,6 +379,7 @@ bool ObjectRecorder::send_appends(bool force, ceph::ref_t<FutureImpl> flush_futu
 
   if (append_bytes > 0) {
     m_last_flush_time = ceph_clock_now();
+    m_pending_time = m_last_flush_time;
 
     uint64_t append_tid = m_append_tid++;
     m_in_flight_tids.insert(append_tid);
@@ -366,7 +394,8 @@ bool ObjectRecorder::send_appends(bool force, ceph::ref_t<FutureImpl> flush_futu
     }
 
     auto rados_completion = librados::Rados::aio_create_completion(
-      new C_AppendFlush(this, append_tid), utils::rados_ctx_callback);
+      new C_AppendFlush(this, append_tid, m_last_flush_time),
+      utils::rados_ctx_callback);
     int r = m_ioctx.aio_operate(m_oid, rados_completion, &op);
     ceph_assert(r == 0);
     rados_completion->release();
@@ -64,6 +64,10 @@ public:
     std::lock_guard locker{*m_lock};
     return m_pending_buffers.size();
   }
+  inline size_t get_in_flight_appends() const {
+    std::lock_guard locker{*m_lock};
+    return m_in_flight_tids.size();
+  }
 
 private:
   FRIEND_MAKE_REF(ObjectRecorder);
@@ -86,14 +90,20 @@ private:
   struct C_AppendFlush : public Context {
     ceph::ref_t<ObjectRecorder> object_recorder;
     uint64_t tid;
-    C_AppendFlush(ceph::ref_t<ObjectRecorder> o, uint64_t _tid)
-        : object_recorder(std::move(o)), tid(_tid) {
+    utime_t start_time;
+    C_AppendFlush(ceph::ref_t<ObjectRecorder> o, uint64_t _tid,
+                  utime_t _start_time)
+        : object_recorder(std::move(o)), tid(_tid), start_time(_start_time) {
     }
     void finish(int r) override {
-      object_recorder->handle_append_flushed(tid, r);
+      object_recorder->handle_append_flushed(tid, r, start_time);
     }
   };
 
+  // max number of batched appends that can be pipelined to the object
+  // when the pending batch outlives the adaptive latency window
+  static const int32_t MAX_PIPELINED_BATCHES = 4;
+
   librados::IoCtx m_ioctx;
   std::string m_oid;
   uint64_t m_object_number;
@@ -127,8 +137,12 @@ private:
   mutable ceph::mutex* m_lock;
   AppendBuffers m_pending_buffers;
   uint64_t m_pending_bytes = 0;
+  utime_t m_pending_time;
   utime_t m_last_flush_time;
 
+  // smoothed append round-trip time (in seconds)
+  double m_avg_append_latency = 0;
+
   uint64_t m_append_tid = 0;
 
   InFlightTids m_in_flight_tids;
@@ -147,7 +161,7 @@ private:
   uint64_t m_in_flight_bytes = 0;
 
   bool send_appends(bool force, ceph::ref_t<FutureImpl> flush_sentinal);
-  void handle_append_flushed(uint64_t tid, int r);
+  void handle_append_flushed(uint64_t tid, int r, utime_t start_time);
   void append_overflowed();
 
   void wake_up_flushes();
@@ -284,7 +284,14 @@ librados::IoCtx duplicate_io_ctx(librados::IoCtx& io_ctx) {
     plb.add_u64_counter(l_librbd_resize, "resize", "Resizes");
     plb.add_u64_counter(l_librbd_readahead, "readahead", "Read ahead");
     plb.add_u64_counter(l_librbd_readahead_bytes, "readahead_bytes", "Data size in read ahead", NULL, 0, unit_t(UNIT_BYTES));
+    plb.add_u64_counter(l_librbd_readahead_hit_bytes, "readahead_hit_bytes", "Read ahead data consumed by reads", NULL, 0, unit_t(UNIT_BYTES));
+    plb.add_u64_counter(l_librbd_readahead_wasted_bytes, "readahead_wasted_bytes", "Read ahead data discarded unread", NULL, 0, unit_t(UNIT_BYTES));
     plb.add_u64_counter(l_librbd_invalidate_cache, "invalidate_cache", "Cache invalidates");
+    plb.add_time_avg(l_librbd_qos_image_throttled_time, "qos_image_throttled_time", "Time IOs were delayed by image QoS limits");
+    plb.add_time_avg(l_librbd_qos_namespace_throttled_time, "qos_namespace_throttled_time", "Time IOs were delayed by namespace QoS limits");
+    plb.add_time_avg(l_librbd_qos_pool_throttled_time, "qos_pool_throttled_time", "Time IOs were delayed by pool QoS limits");
+    plb.add_u64_counter(l_librbd_io_scheduler_writes, "io_scheduler_writes", "Writes coalesced by the IO scheduler");
+    plb.add_u64_counter(l_librbd_io_scheduler_write_ops, "io_scheduler_write_ops", "Write ops issued by the IO scheduler after coalescing");
 
     plb.add_time(l_librbd_opened_time, "opened_time", "Opened time",
                  "ots", perf_prio);
@@ -860,6 +867,18 @@ librados::IoCtx duplicate_io_ctx(librados::IoCtx& io_ctx) {
       config.get_val<uint64_t>("rbd_qos_write_bps_limit"),
       config.get_val<uint64_t>("rbd_qos_write_bps_burst"),
       config.get_val<uint64_t>("rbd_qos_write_bps_burst_seconds"));
+    io_image_dispatcher->apply_qos_limit(
+      io::IMAGE_DISPATCH_FLAG_QOS_NAMESPACE_IOPS_THROTTLE,
+      config.get_val<uint64_t>("rbd_qos_namespace_iops_limit"), 0, 1);
+    io_image_dispatcher->apply_qos_limit(
+      io::IMAGE_DISPATCH_FLAG_QOS_NAMESPACE_BPS_THROTTLE,
+      config.get_val<uint64_t>("rbd_qos_namespace_bps_limit"), 0, 1);
+    io_image_dispatcher->apply_qos_limit(
+      io::IMAGE_DISPATCH_FLAG_QOS_POOL_IOPS_THROTTLE,
+      config.get_val<uint64_t>("rbd_qos_pool_iops_limit"), 0, 1);
+    io_image_dispatcher->apply_qos_limit(
+      io::IMAGE_DISPATCH_FLAG_QOS_POOL_BPS_THROTTLE,
+      config.get_val<uint64_t>("rbd_qos_pool_bps_limit"), 0, 1);
     io_image_dispatcher->apply_qos_exclude_ops(
       librbd::io::rbd_io_operations_from_string(
         config.get_val<std::string>("rbd_qos_exclude_ops"), nullptr));
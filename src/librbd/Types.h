@@ -49,9 +49,18 @@ enum {
 
   l_librbd_readahead,
   l_librbd_readahead_bytes,
+  l_librbd_readahead_hit_bytes,
+  l_librbd_readahead_wasted_bytes,
 
   l_librbd_invalidate_cache,
 
+  l_librbd_qos_image_throttled_time,
+  l_librbd_qos_namespace_throttled_time,
+  l_librbd_qos_pool_throttled_time,
+
+  l_librbd_io_scheduler_writes,
+  l_librbd_io_scheduler_write_ops,
+
   l_librbd_opened_time,
   l_librbd_lock_acquired_time,
 
@@ -233,7 +233,9 @@ int DiffIterate<I>::execute() {
   int r;
   bool fast_diff_enabled = false;
   BitVector<2> object_diff_state;
-  if (m_whole_object) {
+  {
+    // even when exact extents are needed, the object map lets us skip
+    // list_snaps for objects that did not change between the snapshots
     C_SaferCond ctx;
     auto req = object_map::DiffRequest<I>::create(&m_image_ctx, from_snap_id,
                                                   end_snap_id,
@@ -261,11 +263,16 @@ int DiffIterate<I>::execute() {
   uint64_t off = m_offset;
   uint64_t left = m_length;
 
+  uint64_t skipped_periods = 0;
   while (left > 0) {
     uint64_t period_off = off - (off % period);
     uint64_t read_len = std::min(period_off + period - off, left);
 
-    if (fast_diff_enabled) {
+    if (fast_diff_enabled && !m_whole_object &&
+        !is_period_updated(object_diff_state, period_off / period,
+                           diff_context.include_parent)) {
+      ++skipped_periods;
+    } else if (fast_diff_enabled && m_whole_object) {
       // map to extents
       std::map<object_t,std::vector<ObjectExtent> > object_extents;
       Striper::file_to_extents(cct, m_image_ctx.format_string,
@@ -326,9 +333,32 @@ int DiffIterate<I>::execute() {
   if (r < 0) {
     return r;
   }
+  ldout(cct, 10) << "skipped list_snaps for " << skipped_periods
+                 << " unchanged periods" << dendl;
   return 0;
 }
 
+template <typename I>
+bool DiffIterate<I>::is_period_updated(const BitVector<2>& object_diff_state,
+                                       uint64_t period_no,
+                                       bool include_parent) const {
+  uint64_t stripe_count = m_image_ctx.stripe_count;
+  uint64_t object_no = period_no * stripe_count;
+  for (uint64_t i = 0; i < stripe_count; ++i, ++object_no) {
+    if (object_no >= object_diff_state.size()) {
+      return true;
+    }
+    uint8_t diff_state = object_diff_state[object_no];
+    if (diff_state == object_map::DIFF_STATE_HOLE_UPDATED ||
+        diff_state == object_map::DIFF_STATE_DATA_UPDATED ||
+        // a child hole may still expose changed parent data
+        (diff_state == object_map::DIFF_STATE_HOLE && include_parent)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 } // namespace api
 } // namespace librbd
 
@@ -1,6 +1,7 @@
 // -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
 // vim: ts=8 sw=2 smarttab
 
+#include "common/deleter.h"
 #include "common/errno.h"
 #include "include/neorados/RADOS.hpp"
 #include "librbd/ImageCtx.h"
@@ -13,6 +14,10 @@
 #include "osd/osd_types.h"
 #include "osdc/WritebackHandler.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <vector>
 
 #define dout_subsys ceph_subsys_rbd
@@ -32,7 +37,11 @@ ParentCacheObjectDispatch<I>::ParentCacheObjectDispatch(
     I* image_ctx, plugin::Api<I>& plugin_api)
   : m_image_ctx(image_ctx), m_plugin_api(plugin_api),
     m_lock(ceph::make_mutex(
-      "librbd::cache::ParentCacheObjectDispatch::lock", true, false)) {
+      "librbd::cache::ParentCacheObjectDispatch::lock", true, false)),
+    m_max_mapped_objects(image_ctx->cct->_conf.template get_val<uint64_t>(
+      "rbd_parent_cache_max_mapped_objects")),
+    m_mapped_lock(ceph::make_mutex(
+      "librbd::cache::ParentCacheObjectDispatch::mapped_lock")) {
   ceph_assert(m_image_ctx->data_ctx.is_valid());
   auto controller_path = image_ctx->cct->_conf.template get_val<std::string>(
     "immutable_object_cache_sock");
@@ -239,6 +248,15 @@ int ParentCacheObjectDispatch<I>::read_object(
   auto *cct = m_image_ctx->cct;
   ldout(cct, 20) << "file path: " << file_path << dendl;
 
+  bufferptr mapped;
+  if (m_max_mapped_objects > 0 && map_object(file_path, &mapped) == 0) {
+    if (offset < mapped.length()) {
+      read_data->append(bufferptr(
+        mapped, offset, std::min<uint64_t>(length, mapped.length() - offset)));
+    }
+    return read_data->length();
+  }
+
   std::string error;
   int ret = read_data->pread_file(file_path.c_str(), offset, length, &error);
   if (ret < 0) {
@@ -250,6 +268,68 @@ int ParentCacheObjectDispatch<I>::read_object(
   return read_data->length();
 }
 
+template <typename I>
+int ParentCacheObjectDispatch<I>::map_object(const std::string& file_path,
+                                             ceph::bufferptr* mapped) {
+  auto *cct = m_image_ctx->cct;
+
+  std::lock_guard locker{m_mapped_lock};
+  auto it = m_mapped_objects.find(file_path);
+  if (it != m_mapped_objects.end()) {
+    m_mapped_lru.splice(m_mapped_lru.end(), m_mapped_lru, it->second.lru_it);
+    *mapped = it->second.ptr;
+    return 0;
+  }
+
+  int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    int r = -errno;
+    ldout(cct, 5) << "failed to open " << file_path << ": "
+                  << cpp_strerror(r) << dendl;
+    return r;
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) < 0) {
+    int r = -errno;
+    ::close(fd);
+    return r;
+  }
+
+  if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+    // nothing to map, let the regular read path handle it
+    ::close(fd);
+    return -ENODATA;
+  }
+
+  // the daemon never rewrites a cache file in place, so the mapping stays
+  // valid (and keeps the data alive) even after the file is evicted
+  size_t size = st.st_size;
+  void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    int r = -errno;
+    ldout(cct, 5) << "failed to map " << file_path << ": "
+                  << cpp_strerror(r) << dendl;
+    return r;
+  }
+
+  bufferptr ptr(buffer::claim_buffer(
+    size, reinterpret_cast<char*>(addr),
+    make_deleter([addr, size]() { ::munmap(addr, size); })));
+
+  while (m_mapped_objects.size() >= m_max_mapped_objects) {
+    // bufferlists still referencing an evicted mapping keep it alive
+    m_mapped_objects.erase(m_mapped_lru.front());
+    m_mapped_lru.pop_front();
+  }
+
+  auto lru_it = m_mapped_lru.insert(m_mapped_lru.end(), file_path);
+  m_mapped_objects[file_path] = {ptr, lru_it};
+  *mapped = ptr;
+  return 0;
+}
+
 } // namespace cache
 } // namespace librbd
 
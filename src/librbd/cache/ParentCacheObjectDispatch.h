@@ -10,6 +10,9 @@
 #include "tools/immutable_object_cache/CacheClient.h"
 #include "tools/immutable_object_cache/Types.h"
 
+#include <list>
+#include <unordered_map>
+
 namespace librbd {
 
 class ImageCtx;
@@ -136,6 +139,7 @@ private:
 
   int read_object(std::string file_path, ceph::bufferlist* read_data,
                   uint64_t offset, uint64_t length, Context *on_finish);
+  int map_object(const std::string& file_path, ceph::bufferptr* mapped);
   void handle_read_cache(ceph::immutable_obj_cache::ObjectCacheRequest* ack,
                          uint64_t object_no, io::ReadExtents* extents,
                          IOContext io_context,
@@ -151,6 +155,19 @@ private:
   ceph::mutex m_lock;
   CacheClient *m_cache_client = nullptr;
   bool m_connecting = false;
+
+  // promoted cache files are immutable: keep the most recently read ones
+  // mapped so that hits are served without an open and read per request
+  typedef std::list<std::string> MappedObjectLRU;
+  struct MappedObject {
+    ceph::bufferptr ptr;
+    MappedObjectLRU::iterator lru_it;
+  };
+
+  uint64_t m_max_mapped_objects;
+  ceph::mutex m_mapped_lock;
+  MappedObjectLRU m_mapped_lru;
+  std::unordered_map<std::string, MappedObject> m_mapped_objects;
 };
 
 } // namespace cache
@@ -72,6 +72,10 @@ AbstractWriteLog<I>::AbstractWriteLog(
 {
   CephContext *cct = m_image_ctx.cct;
   m_plugin_api.get_image_timer_instance(cct, &m_timer, &m_timer_lock);
+  m_max_flush_ops_in_flight = m_image_ctx.config.template get_val<uint64_t>(
+    "rbd_persistent_cache_flush_ops_in_flight");
+  m_max_flush_bytes_in_flight = m_image_ctx.config.template get_val<Option::size_t>(
+    "rbd_persistent_cache_flush_bytes_in_flight");
 }
 
 template <typename I>
@@ -261,6 +265,8 @@ void AbstractWriteLog<I>::perf_start(std::string name) {
 
   plb.add_u64_counter(l_librbd_pwl_internal_flush, "internal_flush", "Flush RWL (write back to OSD)");
   plb.add_time_avg(l_librbd_pwl_writeback_latency, "writeback_lat", "write back to OSD latency");
+  plb.add_u64_counter(l_librbd_pwl_writeback_skipped, "writeback_skipped", "Dirty entries not written back because later writes replaced them");
+  plb.add_u64_counter(l_librbd_pwl_writeback_skipped_bytes, "writeback_skipped_bytes", "Bytes not written back because later writes replaced them");
   plb.add_u64_counter(l_librbd_pwl_invalidate_cache, "invalidate", "Invalidate RWL");
   plb.add_u64_counter(l_librbd_pwl_invalidate_discard_cache, "discard", "Discard and invalidate RWL");
 
@@ -434,6 +440,7 @@ void AbstractWriteLog<I>::update_sync_points(std::map<uint64_t, bool> &missing_s
           sync_point_entry->writes++;
           sync_point_entry->bytes += gen_write_entry->ram_entry.write_bytes;
           sync_point_entry->writes_completed++;
+          gen_write_entry->set_persisted();
           m_blocks_to_log_entries.add_log_entry(gen_write_entry);
           /* This entry is only dirty if its sync gen number is > the flushed
            * sync gen number from the root object. */
@@ -1291,6 +1298,10 @@ void AbstractWriteLog<I>::complete_op_log_entries(GenericLogOperations &&ops,
     if (op->is_writing_op()) {
       op->mark_log_entry_completed();
       dirty_entries.push_back(log_entry);
+      if (result >= 0) {
+        /* Entries this one overwrote may now skip writeback */
+        static_pointer_cast<GenericWriteLogEntry>(log_entry)->set_persisted();
+      }
     }
     if (log_entry->is_write_entry()) {
       release_ram(log_entry);
@@ -1621,8 +1632,25 @@ bool AbstractWriteLog<I>::can_flush_entry(std::shared_ptr<GenericLogEntry> log_e
   }
 
   return (log_entry->can_writeback() &&
-         (m_flush_ops_in_flight <= IN_FLIGHT_FLUSH_WRITE_LIMIT) &&
-         (m_flush_bytes_in_flight <= IN_FLIGHT_FLUSH_BYTES_LIMIT));
+         (m_flush_ops_in_flight <= m_max_flush_ops_in_flight) &&
+         (m_flush_bytes_in_flight <= m_max_flush_bytes_in_flight));
+}
+
+/* Returns true if the entry's data never needs to reach the image because
+ * every block of it was overwritten by later entries in the same sync gen.
+ * Writes within one sync gen are flushed concurrently with no ordering
+ * between them, so the later entries alone make the image consistent once
+ * that sync gen is flushed. */
+template <typename I>
+bool AbstractWriteLog<I>::can_skip_writeback(std::shared_ptr<GenericLogEntry> log_entry) {
+  ceph_assert(ceph_mutex_is_locked_by_me(m_lock));
+
+  if (m_invalidating || !log_entry->is_write_entry()) {
+    return false;
+  }
+  auto write_entry = static_pointer_cast<GenericWriteLogEntry>(log_entry);
+  return (m_blocks_to_log_entries.is_occluded(write_entry) &&
+          write_entry->occluded_within_sync_gen());
 }
 
 template <typename I>
@@ -1682,6 +1710,27 @@ Context* AbstractWriteLog<I>::construct_flush_entry(std::shared_ptr<GenericLogEn
   return ctx;
 }
 
+/* Completes a dirty entry that can_skip_writeback() accepted without
+ * writing it back. The entries that overwrote it are flushed to the image,
+ * and through the lower layer, before their sync point is considered
+ * flushed, so this entry needs no lower layer flush of its own. */
+template <typename I>
+void AbstractWriteLog<I>::skip_flush_entry(std::shared_ptr<GenericLogEntry> log_entry) {
+  ceph_assert(ceph_mutex_is_locked_by_me(m_lock));
+
+  ldout(m_image_ctx.cct, 20) << "skipping writeback of overwritten entry: "
+                             << *log_entry << dendl;
+  m_perfcounter->inc(l_librbd_pwl_writeback_skipped, 1);
+  m_perfcounter->inc(l_librbd_pwl_writeback_skipped_bytes,
+                     log_entry->write_bytes());
+
+  ceph_assert(m_bytes_dirty >= log_entry->bytes_dirty());
+  log_entry->set_flushed(true);
+  m_bytes_dirty -= log_entry->bytes_dirty();
+  sync_point_writer_flushed(log_entry->get_sync_point_entry());
+  wake_up();
+}
+
 template <typename I>
 void AbstractWriteLog<I>::process_writeback_dirty_entries() {
   CephContext *cct = m_image_ctx.cct;
@@ -1692,7 +1741,7 @@ void AbstractWriteLog<I>::process_writeback_dirty_entries() {
   {
     DeferredContexts post_unlock;
     std::shared_lock entry_reader_locker(m_entry_reader_lock);
-    while (flushed < IN_FLIGHT_FLUSH_WRITE_LIMIT) {
+    while (flushed < m_max_flush_ops_in_flight) {
       std::lock_guard locker(m_lock);
       if (m_shutting_down) {
         ldout(cct, 5) << "Flush during shutdown supressed" << dendl;
@@ -1709,8 +1758,13 @@ void AbstractWriteLog<I>::process_writeback_dirty_entries() {
       auto candidate = m_dirty_log_entries.front();
       bool flushable = can_flush_entry(candidate);
       if (flushable) {
-        post_unlock.add(construct_flush_entry_ctx(candidate));
-        flushed++;
+        if (can_skip_writeback(candidate)) {
+          /* Nothing is written back, so it doesn't use up a flush slot */
+          skip_flush_entry(candidate);
+        } else {
+          post_unlock.add(construct_flush_entry_ctx(candidate));
+          flushed++;
+        }
         m_dirty_log_entries.pop_front();
       } else {
         ldout(cct, 20) << "Next dirty entry isn't flushable yet" << dendl;
@@ -202,6 +202,9 @@ private:
 
   int m_flush_ops_in_flight = 0;
   int m_flush_bytes_in_flight = 0;
+  /* Initialized from config */
+  int m_max_flush_ops_in_flight;
+  int m_max_flush_bytes_in_flight;
   uint64_t m_lowest_flushing_sync_gen = 0;
 
   /* Writes that have left the block guard, but are waiting for resources */
@@ -347,6 +350,8 @@ protected:
   Context *construct_flush_entry(
       const std::shared_ptr<pwl::GenericLogEntry> log_entry, bool invalidating);
   void process_writeback_dirty_entries();
+  bool can_skip_writeback(const std::shared_ptr<pwl::GenericLogEntry> log_entry);
+  void skip_flush_entry(const std::shared_ptr<pwl::GenericLogEntry> log_entry);
   bool can_retire_entry(const std::shared_ptr<pwl::GenericLogEntry> log_entry);
 
   void dispatch_deferred_writes(void);
@@ -7,8 +7,10 @@
 #include "common/ceph_mutex.h"
 #include "librbd/Utils.h"
 #include "librbd/cache/pwl/Types.h"
+#include <algorithm>
 #include <atomic>
 #include <memory>
+#include <vector>
 
 namespace librbd {
 namespace cache {
@@ -136,6 +138,39 @@ public:
   }
   void inc_map_ref() { referring_map_entries++; }
   void dec_map_ref() { referring_map_entries--; }
+  void occluded_by(const std::shared_ptr<GenericWriteLogEntry> &entry) {
+    /* Called with the LogMap lock held when (part of) this entry is
+     * overwritten by a later one. Entries are added to the map when they
+     * are dispatched, so the overwriting entry may not be in the log yet. */
+    if (entry->ram_entry.sync_gen_number > max_occluding_sync_gen) {
+      max_occluding_sync_gen = entry->ram_entry.sync_gen_number;
+    }
+    if (!entry->is_persisted()) {
+      unpersisted_occluders.push_back(entry);
+    }
+  }
+  /* Called with the LogMap lock held. True once every entry that has
+   * overwritten (part of) this one is persisted in the log. */
+  bool occluders_persisted() {
+    unpersisted_occluders.erase(
+      std::remove_if(unpersisted_occluders.begin(), unpersisted_occluders.end(),
+                     [](const std::shared_ptr<GenericWriteLogEntry> &entry) {
+                       return entry->is_persisted();
+                     }),
+      unpersisted_occluders.end());
+    return unpersisted_occluders.empty();
+  }
+  /* Valid once LogMap::is_occluded() has returned true for this entry */
+  bool occluded_within_sync_gen() const {
+    return max_occluding_sync_gen == ram_entry.sync_gen_number;
+  }
+  /* The append of this entry to the log completed successfully */
+  void set_persisted() {
+    m_persisted = true;
+  }
+  bool is_persisted() const {
+    return m_persisted;
+  }
   bool can_writeback() const override;
   std::shared_ptr<SyncPointLogEntry> get_sync_point_entry() override {
     return sync_point_entry;
@@ -153,6 +188,9 @@ public:
 
 private:
   bool m_flushed = false; /* or invalidated */
+  std::atomic<bool> m_persisted = {false};
+  uint64_t max_occluding_sync_gen = 0;
+  std::vector<std::shared_ptr<GenericWriteLogEntry>> unpersisted_occluders;
 };
 
 class WriteLogEntry : public GenericWriteLogEntry {
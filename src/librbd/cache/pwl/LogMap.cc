@@ -112,6 +112,19 @@ LogMapEntries<T> LogMap<T>::find_map_entries(BlockExtent block_extent) {
   return find_map_entries_locked(block_extent);
 }
 
+/**
+ * Returns true if every block of the supplied write log entry has been
+ * overwritten by later log entries, i.e. no map entry refers to it any
+ * more, and all of those later entries are persisted in the log. Until
+ * then the later writes could still fail, and the supplied entry would be
+ * the only copy of its data.
+ */
+template <typename T>
+bool LogMap<T>::is_occluded(std::shared_ptr<T> log_entry) {
+  std::lock_guard locker(m_lock);
+  return (0 == log_entry->get_map_ref() && log_entry->occluders_persisted());
+}
+
 template <typename T>
 void LogMap<T>::add_log_entry_locked(std::shared_ptr<T> log_entry) {
   LogMapEntry<T> map_entry(log_entry);
@@ -121,6 +134,7 @@ void LogMap<T>::add_log_entry_locked(std::shared_ptr<T> log_entry) {
   LogMapEntries<T> overlap_entries = find_map_entries_locked(map_entry.block_extent);
   for (auto &entry : overlap_entries) {
     ldout(m_cct, 20) << entry << dendl;
+    entry.log_entry->occluded_by(log_entry);
     if (map_entry.block_extent.block_start <= entry.block_extent.block_start) {
       if (map_entry.block_extent.block_end >= entry.block_extent.block_end) {
         ldout(m_cct, 20) << "map entry completely occluded by new log entry" << dendl;
@@ -47,6 +47,7 @@ public:
   void remove_log_entries(std::list<std::shared_ptr<T>> &log_entries);
   std::list<std::shared_ptr<T>> find_log_entries(BlockExtent block_extent);
   LogMapEntries<T> find_map_entries(BlockExtent block_extent);
+  bool is_occluded(std::shared_ptr<T> log_entry);
 
 private:
   void add_log_entry_locked(std::shared_ptr<T> log_entry);
@@ -139,6 +139,8 @@ enum {
 
   l_librbd_pwl_internal_flush,
   l_librbd_pwl_writeback_latency,
+  l_librbd_pwl_writeback_skipped,
+  l_librbd_pwl_writeback_skipped_bytes,
   l_librbd_pwl_invalidate_cache,
   l_librbd_pwl_invalidate_discard_cache,
 
@@ -156,9 +158,6 @@ namespace pwl {
 
 class ImageExtentBuf;
 
-const int IN_FLIGHT_FLUSH_WRITE_LIMIT = 64;
-const int IN_FLIGHT_FLUSH_BYTES_LIMIT = (1 * 1024 * 1024);
-
 /* Limit work between sync points */
 const uint64_t MAX_WRITES_PER_SYNC_POINT = 256;
 const uint64_t MAX_BYTES_PER_SYNC_POINT = (1024 * 1024 * 8);
@@ -15,6 +15,7 @@ template <typename T>
 class CryptoContextPool : public DataCryptor<T>  {
 
 public:
+    // takes ownership of data_cryptor
     CryptoContextPool(DataCryptor<T>* data_cryptor, uint32_t pool_size);
     ~CryptoContextPool();
 
@@ -62,6 +63,41 @@ private:
     }
 };
 
+template <typename T>
+CryptoContextPool<T>::CryptoContextPool(DataCryptor<T>* data_cryptor,
+                                        uint32_t pool_size)
+     : m_data_cryptor(data_cryptor), m_encrypt_contexts(pool_size),
+       m_decrypt_contexts(pool_size) {
+}
+
+template <typename T>
+CryptoContextPool<T>::~CryptoContextPool() {
+  T* ctx;
+  while (m_encrypt_contexts.pop(ctx)) {
+    m_data_cryptor->return_context(ctx, CipherMode::CIPHER_MODE_ENC);
+  }
+  while (m_decrypt_contexts.pop(ctx)) {
+    m_data_cryptor->return_context(ctx, CipherMode::CIPHER_MODE_DEC);
+  }
+  delete m_data_cryptor;
+}
+
+template <typename T>
+T* CryptoContextPool<T>::get_context(CipherMode mode) {
+  T* ctx;
+  if (!get_contexts(mode).pop(ctx)) {
+    ctx = m_data_cryptor->get_context(mode);
+  }
+  return ctx;
+}
+
+template <typename T>
+void CryptoContextPool<T>::return_context(T* ctx, CipherMode mode) {
+  if (!get_contexts(mode).push(ctx)) {
+    m_data_cryptor->return_context(ctx, mode);
+  }
+}
+
 } // namespace crypto
 } // namespace librbd
 
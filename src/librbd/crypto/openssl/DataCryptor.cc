@@ -2,6 +2,7 @@
 // vim: ts=8 sw=2 smarttab
 
 #include "librbd/crypto/openssl/DataCryptor.h"
+#include "librbd/crypto/CryptoContextPool.h"
 #include <openssl/err.h>
 #include <string.h>
 #include "include/ceph_assert.h"
@@ -146,3 +147,5 @@ void DataCryptor::log_errors() const {
 } // namespace openssl
 } // namespace crypto
 } // namespace librbd
+
+template class librbd::crypto::CryptoContextPool<EVP_CIPHER_CTX>;
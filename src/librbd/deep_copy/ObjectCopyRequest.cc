@@ -124,6 +124,16 @@ void ObjectCopyRequest<I>::handle_list_snaps(int r) {
   compute_dst_object_may_exist();
   compute_read_ops();
 
+  if (is_server_side_copy_supported()) {
+    // the OSD can clone the HEAD object directly from the source pool so
+    // there is no need to pull the data through this client
+    ldout(m_cct, 20) << "using server-side copy" << dendl;
+    m_server_side_copy = true;
+    m_dst_object_state[m_snap_map.begin()->first] = OBJECT_EXISTS;
+    send_update_object_map();
+    return;
+  }
+
   send_read();
 }
 
@@ -279,6 +289,11 @@ void ObjectCopyRequest<I>::handle_update_object_map(int r) {
 
 template <typename I>
 void ObjectCopyRequest<I>::process_copyup() {
+  if (m_server_side_copy) {
+    send_copy_object();
+    return;
+  }
+
   if (m_snapshot_sparse_bufferlist.empty()) {
     // no data to copy or truncate/zero. only the copyup state machine cares
     // about whether the object exists or not, and it always copies from
@@ -450,6 +465,83 @@ void ObjectCopyRequest<I>::handle_write_object(int r) {
   finish(0);
 }
 
+template <typename I>
+void ObjectCopyRequest<I>::send_copy_object() {
+  auto src_snap_id = m_snap_map.begin()->first;
+  auto src_oid = m_src_image_ctx->get_object_name(m_dst_object_number);
+  ldout(m_cct, 20) << "src_oid=" << src_oid << ", "
+                   << "src_snap_id=" << src_snap_id << dendl;
+
+  librados::ObjectWriteOperation op;
+  cls_client::assert_snapc_seq(&op, 0,
+                               cls::rbd::ASSERT_SNAPC_SEQ_GT_SNAPSET_SEQ);
+
+  m_src_io_ctx.snap_set_read(src_snap_id);
+  op.copy_from(src_oid, m_src_io_ctx, 0,
+               LIBRADOS_OP_FLAG_FADVISE_SEQUENTIAL |
+               LIBRADOS_OP_FLAG_FADVISE_NOCACHE);
+
+  int r;
+  Context *finish_op_ctx;
+  {
+    std::shared_lock owner_locker{m_dst_image_ctx->owner_lock};
+    finish_op_ctx = start_lock_op(m_dst_image_ctx->owner_lock, &r);
+  }
+  if (finish_op_ctx == nullptr) {
+    lderr(m_cct) << "lost exclusive lock" << dendl;
+    finish(r);
+    return;
+  }
+
+  auto ctx = new LambdaContext([this, finish_op_ctx](int r) {
+      handle_copy_object(r);
+      finish_op_ctx->complete(0);
+    });
+  librados::AioCompletion *comp = create_rados_callback(ctx);
+  std::vector<librados::snap_t> dst_snap_ids;
+  r = m_dst_io_ctx.aio_operate(m_dst_oid, comp, &op, 0, dst_snap_ids, nullptr);
+  ceph_assert(r == 0);
+  comp->release();
+}
+
+template <typename I>
+void ObjectCopyRequest<I>::handle_copy_object(int r) {
+  ldout(m_cct, 20) << "r=" << r << dendl;
+
+  if (r == -EOPNOTSUPP) {
+    // OSDs (or the pool) cannot perform the copy -- fall back to reading
+    // the data through this client
+    ldout(m_cct, 5) << "server-side copy not supported, falling back to "
+                    << "client-side copy" << dendl;
+    m_server_side_copy = false;
+    send_read();
+    return;
+  } else if (r == -ENOENT) {
+    // source object does not exist
+    finish(r);
+    return;
+  } else if (r == -ERANGE) {
+    ldout(m_cct, 10) << "concurrent deep copy" << dendl;
+    r = 0;
+  }
+  if (r < 0) {
+    lderr(m_cct) << "failed to copy to destination object: "
+                 << cpp_strerror(r) << dendl;
+    finish(r);
+    return;
+  }
+
+  if (m_handler != nullptr) {
+    uint64_t bytes = 0;
+    for (auto& [_, read_op] : m_read_ops) {
+      bytes += read_op.image_interval.size();
+    }
+    m_handler->handle_read(bytes);
+  }
+
+  finish(0);
+}
+
 template <typename I>
 Context *ObjectCopyRequest<I>::start_lock_op(ceph::shared_mutex &owner_lock,
 					     int* r) {
@@ -823,6 +915,45 @@ void ObjectCopyRequest<I>::finish(int r) {
   on_finish->complete(r);
 }
 
+template <typename I>
+bool ObjectCopyRequest<I>::is_server_side_copy_supported() {
+  if ((m_flags & OBJECT_COPY_REQUEST_FLAG_MIGRATION) == 0 ||
+      !m_dst_image_ctx->config.template get_val<bool>(
+        "rbd_migration_server_side_copy")) {
+    return false;
+  }
+
+  // only a plain copy of the source HEAD (or a single source snapshot) into
+  // a destination object w/o snapshots can be handed off to the OSD
+  if (m_src_snap_id_start != 0 || m_snap_map.size() != 1 ||
+      m_snap_map.begin()->second.size() != 1 || m_read_ops.empty()) {
+    return false;
+  }
+
+  // the OSD can only reach the source object if both images are accessed
+  // through the same cluster connection
+  if (m_src_io_ctx.get_instance_id() != m_dst_io_ctx.get_instance_id()) {
+    return false;
+  }
+
+  std::shared_lock src_image_locker{m_src_image_ctx->image_lock};
+  std::shared_lock dst_image_locker{m_dst_image_ctx->image_lock};
+  if (m_src_image_ctx->id.empty() || m_src_image_ctx->parent != nullptr ||
+      m_src_image_ctx->crypto != nullptr ||
+      m_dst_image_ctx->crypto != nullptr) {
+    // non-native source formats, clones and encrypted images need the
+    // data to be read through the IO path
+    return false;
+  }
+
+  // objects must map 1:1 between the source and destination images
+  auto& src_layout = m_src_image_ctx->layout;
+  auto& dst_layout = m_dst_image_ctx->layout;
+  return (src_layout.object_size == dst_layout.object_size &&
+          src_layout.stripe_unit == dst_layout.stripe_unit &&
+          src_layout.stripe_count == dst_layout.stripe_count);
+}
+
 template <typename I>
 void ObjectCopyRequest<I>::compute_dst_object_may_exist() {
   std::shared_lock image_locker{m_dst_image_ctx->image_lock};
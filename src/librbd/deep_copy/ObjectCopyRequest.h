@@ -69,7 +69,7 @@ private:
    *    |/---------\
    *    |          | (repeat for each snapshot)
    *    v          |
-   * READ ---------/
+   * READ ---------/ (skip if server-side copy)
    *    |
    *    |     /-----------\
    *    |     |           | (repeat for each snapshot)
@@ -79,9 +79,9 @@ private:
    *    |     /-----------\
    *    |     |           | (repeat for each snapshot)
    *    v     v           |
-   * WRITE_OBJECT --------/
-   *    |
-   *    v
+   * WRITE_OBJECT --------/ (COPY_OBJECT if server-side
+   *    |                    copy -- falls back to READ
+   *    v                    if unsupported)
    * <finish>
    *
    * @endverbatim
@@ -130,6 +130,8 @@ private:
 
   io::AsyncOperation* m_src_async_op = nullptr;
 
+  bool m_server_side_copy = false;
+
   void send_list_snaps();
   void handle_list_snaps(int r);
 
@@ -143,6 +145,9 @@ private:
   void send_write_object();
   void handle_write_object(int r);
 
+  void send_copy_object();
+  void handle_copy_object(int r);
+
   Context *start_lock_op(ceph::shared_mutex &owner_lock, int* r);
 
   void compute_read_ops();
@@ -150,6 +155,7 @@ private:
   void compute_zero_ops();
 
   void compute_dst_object_may_exist();
+  bool is_server_side_copy_supported();
 
   void finish(int r);
 };
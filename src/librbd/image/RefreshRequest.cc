@@ -21,6 +21,7 @@
 #include "librbd/io/ImageDispatchSpec.h"
 #include "librbd/io/ImageDispatcherInterface.h"
 #include "librbd/journal/Policy.h"
+#include <boost/algorithm/string/predicate.hpp>
 
 #define dout_subsys ceph_subsys_rbd
 #undef dout_prefix
@@ -33,6 +34,26 @@ using util::create_rados_callback;
 using util::create_async_context_callback;
 using util::create_context_callback;
 
+namespace {
+
+Context *create_result_context(int *result, Context *on_finish) {
+  return new LambdaContext([result, on_finish](int r) {
+      *result = r;
+      on_finish->complete(0);
+    });
+}
+
+bool is_shared_qos_setting(const std::string& key) {
+  // namespace and pool QoS limits configure token buckets that are shared
+  // by all images of the namespace or pool
+  return (boost::starts_with(key, ImageCtx::METADATA_CONF_PREFIX +
+                                    "rbd_qos_namespace_") ||
+          boost::starts_with(key, ImageCtx::METADATA_CONF_PREFIX +
+                                    "rbd_qos_pool_"));
+}
+
+} // anonymous namespace
+
 template <typename I>
 RefreshRequest<I>::RefreshRequest(I &image_ctx, bool acquiring_lock,
                                   bool skip_open_parent, Context *on_finish)
@@ -533,138 +554,117 @@ void RefreshRequest<I>::send_v2_get_metadata() {
   CephContext *cct = m_image_ctx.cct;
   ldout(cct, 10) << this << " " << __func__ << dendl;
 
+  // the image metadata, pool metadata, op features and group are independent
+  // of each other so retrieve them concurrently to save round-trips
   auto ctx = create_context_callback<
     RefreshRequest<I>, &RefreshRequest<I>::handle_v2_get_metadata>(this);
+  auto gather_ctx = new C_Gather(cct, ctx);
+  m_metadata_r = 0;
+  m_pool_metadata_r = 0;
+  m_op_features_r = 0;
+  m_group_r = 0;
+
   auto req = GetMetadataRequest<I>::create(
     m_image_ctx.md_ctx, m_image_ctx.header_oid, true,
     ImageCtx::METADATA_CONF_PREFIX, ImageCtx::METADATA_CONF_PREFIX, 0U,
-    &m_metadata, ctx);
+    &m_metadata, create_result_context(&m_metadata_r, gather_ctx->new_sub()));
   req->send();
-}
-
-template <typename I>
-Context *RefreshRequest<I>::handle_v2_get_metadata(int *result) {
-  CephContext *cct = m_image_ctx.cct;
-  ldout(cct, 10) << this << " " << __func__ << ": r=" << *result << dendl;
-
-  if (*result < 0) {
-    lderr(cct) << "failed to retrieve metadata: " << cpp_strerror(*result)
-               << dendl;
-    return m_on_finish;
-  }
-
-  send_v2_get_pool_metadata();
-  return nullptr;
-}
-
-template <typename I>
-void RefreshRequest<I>::send_v2_get_pool_metadata() {
-  CephContext *cct = m_image_ctx.cct;
-  ldout(cct, 10) << this << " " << __func__ << dendl;
 
-  auto ctx = create_context_callback<
-    RefreshRequest<I>, &RefreshRequest<I>::handle_v2_get_pool_metadata>(this);
-  auto req = GetMetadataRequest<I>::create(
+  req = GetMetadataRequest<I>::create(
     m_pool_metadata_io_ctx, RBD_INFO, true, ImageCtx::METADATA_CONF_PREFIX,
-    ImageCtx::METADATA_CONF_PREFIX, 0U, &m_metadata, ctx);
+    ImageCtx::METADATA_CONF_PREFIX, 0U, &m_pool_metadata,
+    create_result_context(&m_pool_metadata_r, gather_ctx->new_sub()));
   req->send();
-}
 
-template <typename I>
-Context *RefreshRequest<I>::handle_v2_get_pool_metadata(int *result) {
-  CephContext *cct = m_image_ctx.cct;
-  ldout(cct, 10) << this << " " << __func__ << ": r=" << *result << dendl;
+  if ((m_features & RBD_FEATURE_OPERATIONS) != 0LL) {
+    librados::ObjectReadOperation op;
+    cls_client::op_features_get_start(&op);
 
-  if (*result < 0) {
-    lderr(cct) << "failed to retrieve pool metadata: " << cpp_strerror(*result)
-               << dendl;
-    return m_on_finish;
+    auto comp = create_rados_callback(
+      create_result_context(&m_op_features_r, gather_ctx->new_sub()));
+    m_op_features_bl.clear();
+    int r = m_image_ctx.md_ctx.aio_operate(m_image_ctx.header_oid, comp, &op,
+                                           &m_op_features_bl);
+    ceph_assert(r == 0);
+    comp->release();
   }
 
-  bool thread_safe = m_image_ctx.image_watcher->is_unregistered();
-  m_image_ctx.apply_metadata(m_metadata, thread_safe);
-
-  send_v2_get_op_features();
-  return nullptr;
-}
-
-template <typename I>
-void RefreshRequest<I>::send_v2_get_op_features() {
-  if ((m_features & RBD_FEATURE_OPERATIONS) == 0LL) {
-    send_v2_get_group();
-    return;
-  }
-
-  CephContext *cct = m_image_ctx.cct;
-  ldout(cct, 10) << this << " " << __func__ << dendl;
-
   librados::ObjectReadOperation op;
-  cls_client::op_features_get_start(&op);
+  cls_client::image_group_get_start(&op);
 
-  librados::AioCompletion *comp = create_rados_callback<
-    RefreshRequest<I>, &RefreshRequest<I>::handle_v2_get_op_features>(this);
-  m_out_bl.clear();
+  auto comp = create_rados_callback(
+    create_result_context(&m_group_r, gather_ctx->new_sub()));
+  m_group_bl.clear();
   int r = m_image_ctx.md_ctx.aio_operate(m_image_ctx.header_oid, comp, &op,
-                                         &m_out_bl);
+                                         &m_group_bl);
   ceph_assert(r == 0);
   comp->release();
+
+  gather_ctx->activate();
 }
 
 template <typename I>
-Context *RefreshRequest<I>::handle_v2_get_op_features(int *result) {
+Context *RefreshRequest<I>::handle_v2_get_metadata(int *result) {
   CephContext *cct = m_image_ctx.cct;
   ldout(cct, 10) << this << " " << __func__ << ": "
-                 << "r=" << *result << dendl;
+                 << "metadata_r=" << m_metadata_r << ", "
+                 << "pool_metadata_r=" << m_pool_metadata_r << ", "
+                 << "op_features_r=" << m_op_features_r << ", "
+                 << "group_r=" << m_group_r << dendl;
 
-  // -EOPNOTSUPP handler not required since feature bit implies OSD
-  // supports the method
-  if (*result == 0) {
-    auto it = m_out_bl.cbegin();
-    cls_client::op_features_get_finish(&it, &m_op_features);
-  } else if (*result < 0) {
-    lderr(cct) << "failed to retrieve op features: " << cpp_strerror(*result)
+  if (m_metadata_r < 0) {
+    lderr(cct) << "failed to retrieve metadata: " << cpp_strerror(m_metadata_r)
                << dendl;
+    *result = m_metadata_r;
     return m_on_finish;
   }
 
-  send_v2_get_group();
-  return nullptr;
-}
-
-template <typename I>
-void RefreshRequest<I>::send_v2_get_group() {
-  CephContext *cct = m_image_ctx.cct;
-  ldout(cct, 10) << this << " " << __func__ << dendl;
-
-  librados::ObjectReadOperation op;
-  cls_client::image_group_get_start(&op);
-
-  using klass = RefreshRequest<I>;
-  librados::AioCompletion *comp = create_rados_callback<
-    klass, &klass::handle_v2_get_group>(this);
-  m_out_bl.clear();
-  int r = m_image_ctx.md_ctx.aio_operate(m_image_ctx.header_oid, comp, &op,
-                                         &m_out_bl);
-  ceph_assert(r == 0);
-  comp->release();
-}
+  if (m_pool_metadata_r < 0) {
+    lderr(cct) << "failed to retrieve pool metadata: "
+               << cpp_strerror(m_pool_metadata_r) << dendl;
+    *result = m_pool_metadata_r;
+    return m_on_finish;
+  }
 
-template <typename I>
-Context *RefreshRequest<I>::handle_v2_get_group(int *result) {
-  CephContext *cct = m_image_ctx.cct;
-  ldout(cct, 10) << this << " " << __func__ << ": "
-                 << "r=" << *result << dendl;
+  // -EOPNOTSUPP handler not required since feature bit implies OSD
+  // supports the method
+  if (m_op_features_r < 0) {
+    lderr(cct) << "failed to retrieve op features: "
+               << cpp_strerror(m_op_features_r) << dendl;
+    *result = m_op_features_r;
+    return m_on_finish;
+  } else if ((m_features & RBD_FEATURE_OPERATIONS) != 0LL) {
+    auto it = m_op_features_bl.cbegin();
+    cls_client::op_features_get_finish(&it, &m_op_features);
+  }
 
-  if (*result == 0) {
-    auto it = m_out_bl.cbegin();
+  if (m_group_r == 0) {
+    auto it = m_group_bl.cbegin();
     cls_client::image_group_get_finish(&it, &m_group_spec);
-  }
-  if (*result < 0 && *result != -EOPNOTSUPP) {
-    lderr(cct) << "failed to retrieve group: " << cpp_strerror(*result)
+  } else if (m_group_r < 0 && m_group_r != -EOPNOTSUPP) {
+    lderr(cct) << "failed to retrieve group: " << cpp_strerror(m_group_r)
                << dendl;
+    *result = m_group_r;
     return m_on_finish;
   }
 
+  // shared limits must agree across images, so only pool-level settings
+  // apply to them
+  for (auto it = m_metadata.begin(); it != m_metadata.end(); ) {
+    if (is_shared_qos_setting(it->first)) {
+      ldout(cct, 5) << "ignoring image-level setting " << it->first << dendl;
+      it = m_metadata.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // image-level settings take precedence over pool-level settings
+  m_metadata.insert(m_pool_metadata.begin(), m_pool_metadata.end());
+
+  bool thread_safe = m_image_ctx.image_watcher->is_unregistered();
+  m_image_ctx.apply_metadata(m_metadata, thread_safe);
+
   send_v2_get_snapshots();
   return nullptr;
 }
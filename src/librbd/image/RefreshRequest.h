@@ -61,21 +61,10 @@ private:
    *  * * * * * GET_MIGRATION_HEADER (skip if not             |
    *  (ENOENT)      |                 migrating)              |
    *                v                                         |
-   *            V2_GET_METADATA                               |
-   *                |                                         |
-   *                v                                         |
-   *            V2_GET_POOL_METADATA                          |
-   *                |                                         |
-   *                v (skip if not enabled)                   |
-   *            V2_GET_OP_FEATURES                            |
-   *                |                                         |
+   *            V2_GET_METADATA (image and pool metadata,     |
+   *                |            op features and group        |
+   *                |            retrieved concurrently)      |
    *                v                                         |
-   *            V2_GET_GROUP                                  |
-   *                |                                         |
-   *                |     -EOPNOTSUPP                         |
-   *                |   * * * *                               |
-   *                |   *     *                               |
-   *                v   v     *                               |
    *            V2_GET_SNAPSHOTS (skip if no snaps)           |
    *                |                                         |
    *                v                                         |
@@ -155,6 +144,13 @@ private:
 
   librados::IoCtx m_pool_metadata_io_ctx;
   std::map<std::string, bufferlist> m_metadata;
+  std::map<std::string, bufferlist> m_pool_metadata;
+  bufferlist m_op_features_bl;
+  bufferlist m_group_bl;
+  int m_metadata_r = 0;
+  int m_pool_metadata_r = 0;
+  int m_op_features_r = 0;
+  int m_group_r = 0;
 
   std::string m_object_prefix;
   ParentImageInfo m_parent_md;
@@ -199,15 +195,6 @@ private:
   void send_v2_get_metadata();
   Context *handle_v2_get_metadata(int *result);
 
-  void send_v2_get_pool_metadata();
-  Context *handle_v2_get_pool_metadata(int *result);
-
-  void send_v2_get_op_features();
-  Context *handle_v2_get_op_features(int *result);
-
-  void send_v2_get_group();
-  Context *handle_v2_get_group(int *result);
-
   void send_v2_get_snapshots();
   Context *handle_v2_get_snapshots(int *result);
 
@@ -157,6 +157,50 @@ void CopyupRequest<I>::send() {
   read_from_parent();
 }
 
+template <typename I>
+void CopyupRequest<I>::prune_parent_read_extents() {
+  ceph_assert(ceph_mutex_is_locked(m_image_ctx->image_lock));
+
+  std::lock_guard locker{m_lock};
+  bool copy_on_read = m_pending_requests.empty();
+  bool maybe_deep_copyup = !m_image_ctx->snapc.snaps.empty();
+  if (copy_on_read || maybe_deep_copyup || m_write_object_extents.empty()) {
+    return;
+  }
+
+  // optimization: a partial copy-up discards the parent data that is
+  // overwritten by the pending write-ops, so avoid reading it
+  interval_set<uint64_t> image_extents;
+  for (auto [image_offset, image_length] : m_image_extents) {
+    image_extents.union_insert(image_offset, image_length);
+  }
+
+  for (auto [object_offset, object_length] : m_write_object_extents) {
+    Extents write_image_extents;
+    util::extent_to_file(m_image_ctx, m_object_no, object_offset,
+                         object_length, write_image_extents);
+    for (auto [image_offset, image_length] : write_image_extents) {
+      interval_set<uint64_t> write_extents;
+      write_extents.insert(image_offset, image_length);
+
+      interval_set<uint64_t> intersection;
+      intersection.intersection_of(write_extents, image_extents);
+      image_extents.subtract(intersection);
+    }
+  }
+
+  m_partial_parent_read = true;
+  m_image_extents.clear();
+  m_image_extents.reserve(image_extents.num_intervals());
+  for (auto [image_offset, image_length] : image_extents) {
+    m_image_extents.emplace_back(image_offset, image_length);
+  }
+
+  ldout(m_image_ctx->cct, 20) << "write_object_extents="
+                              << m_write_object_extents << ", "
+                              << "image_extents=" << m_image_extents << dendl;
+}
+
 template <typename I>
 void CopyupRequest<I>::read_from_parent() {
   auto cct = m_image_ctx->cct;
@@ -173,6 +217,15 @@ void CopyupRequest<I>::read_from_parent() {
     return;
   }
 
+  prune_parent_read_extents();
+  if (m_image_extents.empty()) {
+    ldout(cct, 20) << "parent data fully overwritten" << dendl;
+
+    m_image_ctx->asio_engine->post(
+      [this]() { handle_read_from_parent(0); });
+    return;
+  }
+
   auto comp = AioCompletion::create_and_start<
     CopyupRequest<I>,
     &CopyupRequest<I>::handle_read_from_parent>(
@@ -211,7 +264,15 @@ void CopyupRequest<I>::handle_read_from_parent(int r) {
   disable_append_requests();
 
   r = prepare_copyup_data();
-  if (r < 0) {
+  if (r == -ERESTART) {
+    m_lock.unlock();
+    m_image_ctx->image_lock.unlock_shared();
+
+    ldout(cct, 5) << "snapshot created during partial copy-up, restarting"
+                  << dendl;
+    finish(r);
+    return;
+  } else if (r < 0) {
     m_lock.unlock();
     m_image_ctx->image_lock.unlock_shared();
 
@@ -699,7 +760,10 @@ int CopyupRequest<I>::prepare_copyup_data() {
 
   bool copy_on_read = m_pending_requests.empty();
   bool maybe_deep_copyup = !m_image_ctx->snapc.snaps.empty();
-  if (copy_on_read || maybe_deep_copyup) {
+  if (maybe_deep_copyup && m_partial_parent_read) {
+    // the parent data overwritten by the write-ops was never read
+    return -ERESTART;
+  } else if (copy_on_read || maybe_deep_copyup) {
     // stand-alone copyup that will not be overwritten until HEAD revision
     ldout(cct, 20) << "processing full copy-up" << dendl;
 
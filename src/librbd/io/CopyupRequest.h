@@ -89,6 +89,7 @@ private:
   bool m_copyup_required = true;
   bool m_copyup_is_zero = true;
   bool m_deep_copied = false;
+  bool m_partial_parent_read = false;
 
   Extents m_copyup_extent_map;
   ceph::bufferlist m_copyup_data;
@@ -108,6 +109,7 @@ private:
 
   interval_set<uint64_t> m_write_object_extents;
 
+  void prune_parent_read_extents();
   void read_from_parent();
   void handle_read_from_parent(int r);
 
@@ -152,6 +152,16 @@ void readahead(I *ictx, const Extents& image_extents, IOContext io_context) {
   uint64_t readahead_offset = readahead_extent.first;
   uint64_t readahead_length = readahead_extent.second;
 
+  auto readahead_stats = ictx->readahead.consume_stats();
+  if (readahead_stats.hit_bytes > 0) {
+    ictx->perfcounter->inc(l_librbd_readahead_hit_bytes,
+                           readahead_stats.hit_bytes);
+  }
+  if (readahead_stats.wasted_bytes > 0) {
+    ictx->perfcounter->inc(l_librbd_readahead_wasted_bytes,
+                           readahead_stats.wasted_bytes);
+  }
+
   if (readahead_length > 0) {
     ldout(ictx->cct, 20) << "(readahead logical) " << readahead_offset << "~"
                          << readahead_length << dendl;
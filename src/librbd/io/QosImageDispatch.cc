@@ -3,9 +3,12 @@
 
 #include "librbd/io/QosImageDispatch.h"
 #include "common/dout.h"
+#include "include/stringify.h"
 #include "librbd/AsioEngine.h"
 #include "librbd/ImageCtx.h"
 #include "librbd/io/FlushTracker.h"
+#include "librbd/Types.h"
+#include <map>
 #include <utility>
 
 #define dout_subsys ceph_subsys_rbd
@@ -45,6 +48,103 @@ static const std::pair<uint64_t, const char*> throttle_flags[] = {
   {IMAGE_DISPATCH_FLAG_QOS_WRITE_BPS_THROTTLE,  "rbd_qos_write_bps_throttle"  }
 };
 
+static const std::pair<uint64_t, const char*> shared_throttle_flags[] = {
+  {IMAGE_DISPATCH_FLAG_QOS_NAMESPACE_IOPS_THROTTLE, "rbd_qos_namespace_iops_throttle"},
+  {IMAGE_DISPATCH_FLAG_QOS_NAMESPACE_BPS_THROTTLE,  "rbd_qos_namespace_bps_throttle" },
+  {IMAGE_DISPATCH_FLAG_QOS_POOL_IOPS_THROTTLE,      "rbd_qos_pool_iops_throttle"     },
+  {IMAGE_DISPATCH_FLAG_QOS_POOL_BPS_THROTTLE,       "rbd_qos_pool_bps_throttle"      }
+};
+
+int get_throttled_time_counter(uint64_t flag) {
+  if ((flag & IMAGE_DISPATCH_FLAG_QOS_POOL_MASK) != 0) {
+    return l_librbd_qos_pool_throttled_time;
+  } else if ((flag & IMAGE_DISPATCH_FLAG_QOS_NAMESPACE_MASK) != 0) {
+    return l_librbd_qos_namespace_throttled_time;
+  }
+  return l_librbd_qos_image_throttled_time;
+}
+
+/*
+ * Registry of the throttles shared by all images of a pool or namespace.
+ * Since a shared bucket is drained by whichever image is busy, idle images
+ * implicitly lend their share of the aggregate limit to the active ones.
+ *
+ * Every image applies the shared limits on each refresh, so the registry
+ * remembers what a throttle was configured with and only reconfigures it
+ * when the value changes: resetting the limit restarts the token refill
+ * and would let each refresh hand out extra tokens.
+ */
+struct SharedThrottles {
+  struct Entry {
+    std::weak_ptr<TokenBucketThrottle> throttle;
+    uint64_t limit = 0;
+    uint64_t schedule_tick_min = 0;
+  };
+
+  ceph::mutex lock = ceph::make_mutex(
+    "librbd::io::QosImageDispatch::SharedThrottles::lock");
+  std::map<std::string, Entry> throttles;
+
+  explicit SharedThrottles(CephContext*) {
+  }
+
+  std::shared_ptr<TokenBucketThrottle> get(CephContext* cct,
+                                           const std::string& name,
+                                           SafeTimer* timer,
+                                           ceph::mutex* timer_lock) {
+    std::lock_guard locker{lock};
+    auto it = throttles.find(name);
+    if (it != throttles.end()) {
+      auto throttle = it->second.throttle.lock();
+      if (throttle) {
+        return throttle;
+      }
+    }
+
+    // prune throttles of pools and namespaces which are no longer in use
+    for (auto it = throttles.begin(); it != throttles.end(); ) {
+      if (it->second.throttle.expired()) {
+        it = throttles.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    auto throttle = std::make_shared<TokenBucketThrottle>(
+      cct, name, 0, 0, timer, timer_lock);
+    throttles[name] = Entry{throttle};
+    return throttle;
+  }
+
+  void set_limit(TokenBucketThrottle* throttle, uint64_t limit) {
+    std::lock_guard locker{lock};
+    auto& entry = throttles.at(throttle->get_name());
+    if (entry.limit != limit) {
+      entry.limit = limit;
+      throttle->set_limit(limit, 0, 1);
+    }
+  }
+
+  void set_schedule_tick_min(TokenBucketThrottle* throttle, uint64_t tick) {
+    std::lock_guard locker{lock};
+    auto& entry = throttles.at(throttle->get_name());
+    if (entry.schedule_tick_min != tick) {
+      entry.schedule_tick_min = tick;
+      throttle->set_schedule_tick_min(tick);
+    }
+  }
+};
+
+SharedThrottles* get_shared_throttles(CephContext* cct) {
+  return &cct->lookup_or_create_singleton_object<SharedThrottles>(
+    "librbd::io::QosImageDispatch::shared_throttles", false, cct);
+}
+
+bool is_shared_throttle(uint64_t flag) {
+  return ((flag & (IMAGE_DISPATCH_FLAG_QOS_NAMESPACE_MASK |
+                   IMAGE_DISPATCH_FLAG_QOS_POOL_MASK)) != 0);
+}
+
 } // anonymous namespace
 
 template <typename I>
@@ -59,15 +159,25 @@ QosImageDispatch<I>::QosImageDispatch(I* image_ctx)
   for (auto [flag, name] : throttle_flags) {
     m_throttles.emplace_back(
       flag,
-      new TokenBucketThrottle(cct, name, 0, 0, timer, timer_lock));
+      std::make_shared<TokenBucketThrottle>(cct, name, 0, 0, timer,
+                                            timer_lock));
+  }
+
+  auto shared_throttles = get_shared_throttles(cct);
+  auto pool_key = stringify(m_image_ctx->md_ctx.get_id());
+  auto namespace_key = pool_key + "/" + m_image_ctx->md_ctx.get_namespace();
+  for (auto [flag, name] : shared_throttle_flags) {
+    auto key = ((flag & IMAGE_DISPATCH_FLAG_QOS_POOL_MASK) != 0 ?
+                  pool_key : namespace_key);
+    m_throttles.emplace_back(
+      flag,
+      shared_throttles->get(cct, std::string(name) + ":" + key, timer,
+                            timer_lock));
   }
 }
 
 template <typename I>
 QosImageDispatch<I>::~QosImageDispatch() {
-  for (auto t : m_throttles) {
-    delete t.second;
-  }
 }
 
 template <typename I>
@@ -78,8 +188,18 @@ void QosImageDispatch<I>::shut_down(Context* on_finish) {
 
 template <typename I>
 void QosImageDispatch<I>::apply_qos_schedule_tick_min(uint64_t tick) {
-  for (auto pair : m_throttles) {
-    pair.second->set_schedule_tick_min(tick);
+  // the shared throttles follow the client configuration rather than the
+  // overrides of whichever image happens to refresh
+  auto cct = m_image_ctx->cct;
+  auto shared_tick = cct->_conf.template get_val<uint64_t>(
+    "rbd_qos_schedule_tick_min");
+  for (auto& [flag, throttle] : m_throttles) {
+    if (is_shared_throttle(flag)) {
+      get_shared_throttles(cct)->set_schedule_tick_min(throttle.get(),
+                                                       shared_tick);
+    } else {
+      throttle->set_schedule_tick_min(tick);
+    }
   }
 }
 
@@ -88,21 +208,26 @@ void QosImageDispatch<I>::apply_qos_limit(uint64_t flag, uint64_t limit,
                                           uint64_t burst, uint64_t burst_seconds) {
   auto cct = m_image_ctx->cct;
   TokenBucketThrottle *throttle = nullptr;
-  for (auto pair : m_throttles) {
+  for (auto& pair : m_throttles) {
     if (flag == pair.first) {
-      throttle = pair.second;
+      throttle = pair.second.get();
       break;
     }
   }
   ceph_assert(throttle != nullptr);
 
-  int r = throttle->set_limit(limit, burst, burst_seconds);
-  if (r < 0) {
-    lderr(cct) << throttle->get_name() << ": invalid qos parameter: "
-               << "burst(" << burst << ") is less than "
-               << "limit(" << limit << ")" << dendl;
-    // if apply failed, we should at least make sure the limit works.
-    throttle->set_limit(limit, 0, 1);
+  if (is_shared_throttle(flag)) {
+    // shared limits have no burst and only take effect when they change
+    get_shared_throttles(cct)->set_limit(throttle, limit);
+  } else {
+    int r = throttle->set_limit(limit, burst, burst_seconds);
+    if (r < 0) {
+      lderr(cct) << throttle->get_name() << ": invalid qos parameter: "
+                 << "burst(" << burst << ") is less than "
+                 << "limit(" << limit << ")" << dendl;
+      // if apply failed, we should at least make sure the limit works.
+      throttle->set_limit(limit, 0, 1);
+    }
   }
 
   if (limit) {
@@ -291,7 +416,7 @@ bool QosImageDispatch<I>::needs_throttle(
   *dispatch_result = DISPATCH_RESULT_CONTINUE;
 
   auto qos_enabled_flag = m_qos_enabled_flag;
-  for (auto [flag, throttle] : m_throttles) {
+  for (auto& [flag, throttle] : m_throttles) {
     if ((qos_enabled_flag & flag) == 0) {
       all_qos_flags_set = set_throttle_flag(image_dispatch_flags, flag);
       continue;
@@ -317,6 +442,9 @@ void QosImageDispatch<I>::handle_throttle_ready(Tag&& tag, uint64_t flag) {
   ldout(cct, 15) << "on_dispatched=" << tag.on_dispatched << ", "
                  << "flag=" << flag << dendl;
 
+  m_image_ctx->perfcounter->tinc(get_throttled_time_counter(flag),
+                                 coarse_mono_clock::now() - tag.start_time);
+
   if (set_throttle_flag(tag.image_dispatch_flags, flag)) {
     // timer_lock is held -- so dispatch from outside the timer thread
     m_image_ctx->asio_engine->post(tag.on_dispatched, 0);
@@ -10,6 +10,7 @@
 #include "librbd/io/ImageDispatchInterface.h"
 #include "include/int_types.h"
 #include "include/buffer.h"
+#include "common/ceph_time.h"
 #include "common/zipkin_trace.h"
 #include "common/Throttle.h"
 #include "librbd/io/ReadResult.h"
@@ -32,10 +33,12 @@ public:
   struct Tag {
     std::atomic<uint32_t>* image_dispatch_flags;
     Context* on_dispatched;
+    coarse_mono_time start_time;
 
     Tag(std::atomic<uint32_t>* image_dispatch_flags, Context* on_dispatched)
       : image_dispatch_flags(image_dispatch_flags),
-        on_dispatched(on_dispatched) {
+        on_dispatched(on_dispatched),
+        start_time(coarse_mono_clock::now()) {
     }
   };
 
@@ -110,7 +113,10 @@ public:
 private:
   ImageCtxT* m_image_ctx;
 
-  std::list<std::pair<uint64_t, TokenBucketThrottle*> > m_throttles;
+  // per-image throttles followed by the namespace and pool throttles,
+  // the latter being shared with all other images of the same namespace
+  // or pool that are opened through the same client
+  std::list<std::pair<uint64_t, std::shared_ptr<TokenBucketThrottle>>> m_throttles;
   uint64_t m_qos_enabled_flag = 0;
   uint64_t m_qos_exclude_ops = 0;
 
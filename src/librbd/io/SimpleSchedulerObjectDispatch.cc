@@ -4,6 +4,7 @@
 #include "librbd/io/SimpleSchedulerObjectDispatch.h"
 #include "include/neorados/RADOS.hpp"
 #include "common/ceph_time.h"
+#include "common/perf_counters.h"
 #include "common/Timer.h"
 #include "common/errno.h"
 #include "librbd/AsioEngine.h"
@@ -67,7 +68,7 @@ bool SimpleSchedulerObjectDispatch<I>::ObjectRequests::try_delay_request(
   if (!m_delayed_requests.empty()) {
     if (!m_io_context || *m_io_context != *io_context ||
         op_flags != m_op_flags || data.length() == 0 ||
-        intersects(object_off, data.length())) {
+        m_delayed_zero_length_request) {
       return false;
     }
   } else {
@@ -80,67 +81,60 @@ bool SimpleSchedulerObjectDispatch<I>::ObjectRequests::try_delay_request(
     // and we don't want it to be merged with others
     ceph_assert(m_delayed_requests.empty());
     m_delayed_request_extents.insert(0, UINT64_MAX);
+    m_delayed_zero_length_request = true;
   } else {
-    m_delayed_request_extents.insert(object_off, data.length());
+    m_delayed_request_extents.union_insert(object_off, data.length());
   }
   m_object_dispatch_flags |= object_dispatch_flags;
 
-  if (!m_delayed_requests.empty()) {
-    // try to merge front to an existing request
-    auto iter = m_delayed_requests.find(object_off + data.length());
-    if (iter != m_delayed_requests.end()) {
-      auto new_iter = m_delayed_requests.insert({object_off, {}}).first;
-      new_iter->second.data = std::move(data);
-      new_iter->second.data.append(std::move(iter->second.data));
-      new_iter->second.requests = std::move(iter->second.requests);
-      new_iter->second.requests.push_back(on_dispatched);
-      m_delayed_requests.erase(iter);
-
-      if (new_iter != m_delayed_requests.begin()) {
-        auto prev = new_iter;
-        try_merge_delayed_requests(--prev, new_iter);
-      }
-      return true;
-    }
-
-    // try to merge back to an existing request
-    iter = m_delayed_requests.lower_bound(object_off);
-    if (iter == m_delayed_requests.end() || iter->first > object_off) {
-      iter--;
-    }
-    if (iter != m_delayed_requests.end() &&
-        iter->first + iter->second.data.length() == object_off) {
-      iter->second.data.append(std::move(data));
-      iter->second.requests.push_back(on_dispatched);
-
-      auto next = iter;
-      if (++next != m_delayed_requests.end()) {
-        try_merge_delayed_requests(iter, next);
-      }
-      return true;
-    }
-  }
-
-  // create a new request
-  auto iter = m_delayed_requests.insert({object_off, {}}).first;
-  iter->second.data = std::move(data);
-  iter->second.requests.push_back(on_dispatched);
+  merge_delayed_request(object_off, std::move(data), on_dispatched);
   return true;
 }
 
 template <typename I>
-void SimpleSchedulerObjectDispatch<I>::ObjectRequests::try_merge_delayed_requests(
-    typename std::map<uint64_t, MergedRequests>::iterator &iter1,
-    typename std::map<uint64_t, MergedRequests>::iterator &iter2) {
-  if (iter1->first + iter1->second.data.length() != iter2->first) {
-    return;
+void SimpleSchedulerObjectDispatch<I>::ObjectRequests::merge_delayed_request(
+    uint64_t object_off, ceph::bufferlist&& data, Context* on_dispatched) {
+  uint64_t object_end = object_off + data.length();
+
+  // find the first delayed request that overlaps or is adjacent to the
+  // new request
+  auto iter = m_delayed_requests.upper_bound(object_off);
+  if (iter != m_delayed_requests.begin()) {
+    auto prev = std::prev(iter);
+    if (prev->first + prev->second.data.length() >= object_off) {
+      iter = prev;
+    }
+  }
+
+  // the new request was issued after the delayed requests so its data
+  // replaces any overlapping delayed data
+  MergedRequests merged_requests;
+  uint64_t merged_off = object_off;
+  uint64_t merged_end = object_end;
+  if (iter != m_delayed_requests.end() && iter->first < object_off) {
+    merged_off = iter->first;
+    merged_requests.data.substr_of(iter->second.data, 0,
+                                   object_off - iter->first);
+  }
+  merged_requests.data.append(std::move(data));
+
+  while (iter != m_delayed_requests.end() && iter->first <= object_end) {
+    auto &delayed_requests = iter->second;
+    uint64_t delayed_end = iter->first + delayed_requests.data.length();
+    if (delayed_end > merged_end) {
+      ceph::bufferlist sub_bl;
+      sub_bl.substr_of(delayed_requests.data, merged_end - iter->first,
+                       delayed_end - merged_end);
+      merged_requests.data.append(std::move(sub_bl));
+      merged_end = delayed_end;
+    }
+    merged_requests.requests.splice(merged_requests.requests.end(),
+                                    delayed_requests.requests);
+    iter = m_delayed_requests.erase(iter);
   }
 
-  iter1->second.data.append(std::move(iter2->second.data));
-  iter1->second.requests.insert(iter1->second.requests.end(),
-                                iter2->second.requests.begin(),
-                                iter2->second.requests.end());
-  m_delayed_requests.erase(iter2);
+  merged_requests.requests.push_back(on_dispatched);
+  m_delayed_requests[merged_off] = std::move(merged_requests);
 }
 
 template <typename I>
@@ -150,6 +144,10 @@ void SimpleSchedulerObjectDispatch<I>::ObjectRequests::dispatch_delayed_requests
     auto offset = it.first;
     auto &merged_requests = it.second;
 
+    image_ctx->perfcounter->inc(l_librbd_io_scheduler_writes,
+                                merged_requests.requests.size());
+    image_ctx->perfcounter->inc(l_librbd_io_scheduler_write_ops);
+
     auto ctx = new LambdaContext(
         [requests=std::move(merged_requests.requests), latency_stats,
          latency_stats_lock, start_time=ceph_clock_now()](int r) {
@@ -180,10 +180,10 @@ private:
     int m_object_dispatch_flags = 0;
     std::map<uint64_t, MergedRequests> m_delayed_requests;
     interval_set<uint64_t> m_delayed_request_extents;
+    bool m_delayed_zero_length_request = false;
 
-    void try_merge_delayed_requests(
-        typename std::map<uint64_t, MergedRequests>::iterator &iter,
-        typename std::map<uint64_t, MergedRequests>::iterator &iter2);
+    void merge_delayed_request(uint64_t object_off, ceph::bufferlist&& data,
+                               Context* on_dispatched);
   };
 
   typedef std::shared_ptr<ObjectRequests> ObjectRequestsRef;
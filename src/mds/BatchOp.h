@@ -17,6 +17,7 @@
 #define MDS_BATCHOP_H
 
 #include "common/ref.h"
+#include "include/mempool.h"
 
 #include "mdstypes.h"
 
@@ -37,4 +38,8 @@ protected:
   virtual void _respond(mds_rank_t) = 0;
 };
 
+// mask -> in-flight batched getattr/lookup; empty for nearly every cached
+// inode and dentry, so keep it to a single pointer until used.
+using BatchOpMap = mempool::mds_co::compact_map<int, std::unique_ptr<BatchOp>>;
+
 #endif
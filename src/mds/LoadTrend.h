@@ -0,0 +1,93 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_MDS_LOADTREND_H
+#define CEPH_MDS_LOADTREND_H
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Short-term load trend of a single dirfrag.
+ *
+ * Double exponential (Holt) smoothing over irregularly spaced samples of
+ * a popularity counter: it tracks a smoothed level and its slope per
+ * second, so the balancer can act on where the load is heading rather
+ * than only on where it is.  Time is passed in by the caller, in
+ * seconds, which keeps this usable from offline simulations.
+ *
+ * The slope is damped by a factor of phi per second, both when it is
+ * carried forward between samples and when it is projected.  A decaying
+ * counter fed a rate that stopped growing keeps rising for a while as it
+ * converges on its steady state; an undamped projection of that rise
+ * would overshoot the plateau and flag a directory that never gets hot.
+ */
+class LoadTrend {
+public:
+  LoadTrend(double alpha = 0.5, double beta = 0.3, double min_interval = 0.5,
+            double phi = 0.92)
+    : alpha(alpha), beta(beta), min_interval(min_interval), phi(phi) {}
+
+  /**
+   * Feed a sample of the load at time @now (seconds).  Samples closer
+   * than min_interval to the previous accepted one are ignored.
+   *
+   * @returns true if the sample was taken into account
+   */
+  bool sample(double now, double value) {
+    if (!primed) {
+      level = value;
+      trend = 0;
+      last = now;
+      primed = true;
+      return true;
+    }
+    double dt = now - last;
+    if (dt < min_interval)
+      return false;
+    double prev = level;
+    level = alpha * value + (1 - alpha) * (level + trend * damped(dt));
+    trend = beta * (level - prev) / dt + (1 - beta) * trend * std::pow(phi, dt);
+    last = now;
+    return true;
+  }
+
+  /// projected load @horizon seconds after the last sample
+  double predict(double horizon) const {
+    return std::max(0.0, level + trend * damped(horizon));
+  }
+
+  double get_level() const { return level; }
+  double get_trend() const { return trend; }
+  double get_last() const { return last; }
+  bool is_primed() const { return primed; }
+
+private:
+  /// how far the current slope carries over @t seconds once damped
+  double damped(double t) const {
+    if (phi >= 1)
+      return t;
+    return (1 - std::pow(phi, t)) / -std::log(phi);
+  }
+
+  double alpha;
+  double beta;
+  double min_interval;
+  double phi;
+
+  bool primed = false;
+  double level = 0;
+  double trend = 0;
+  double last = 0;
+};
+
+#endif
@@ -78,6 +78,8 @@ MDBalancer::MDBalancer(MDSRank *m, Messenger *msgr, MonClient *monc) :
 {
   bal_fragment_dirs = g_conf().get_val<bool>("mds_bal_fragment_dirs");
   bal_fragment_interval = g_conf().get_val<int64_t>("mds_bal_fragment_interval");
+  bal_predict_horizon = g_conf().get_val<double>("mds_bal_predict_horizon");
+  bal_migration_hysteresis = g_conf().get_val<double>("mds_bal_migration_hysteresis");
 }
 
 void MDBalancer::handle_conf_change(const std::set<std::string>& changed, const MDSMap& mds_map)
@@ -86,6 +88,16 @@ void MDBalancer::handle_conf_change(const std::set<std::string>& changed, const
     bal_fragment_dirs = g_conf().get_val<bool>("mds_bal_fragment_dirs");
   if (changed.count("mds_bal_fragment_interval"))
     bal_fragment_interval = g_conf().get_val<int64_t>("mds_bal_fragment_interval");
+  if (changed.count("mds_bal_predict_horizon")) {
+    bal_predict_horizon = g_conf().get_val<double>("mds_bal_predict_horizon");
+    if (bal_predict_horizon <= 0)
+      frag_trends.clear();
+  }
+  if (changed.count("mds_bal_migration_hysteresis")) {
+    bal_migration_hysteresis = g_conf().get_val<double>("mds_bal_migration_hysteresis");
+    if (bal_migration_hysteresis <= 0)
+      import_stamps.clear();
+  }
 }
 
 void MDBalancer::handle_export_pins(void)
@@ -233,6 +245,23 @@ void MDBalancer::tick()
     last_sample = now;
   }
 
+  // forget trends of fragments that cooled down or went away, and
+  // import stamps that are past the hysteresis window
+  double stale = bal_predict_horizon + g_conf()->mds_bal_sample_interval;
+  double now_sec = chrono::duration<double>(now.time_since_epoch()).count();
+  for (auto p = frag_trends.begin(); p != frag_trends.end(); ) {
+    if (now_sec - p->second.get_last() > stale)
+      p = frag_trends.erase(p);
+    else
+      ++p;
+  }
+  for (auto p = import_stamps.begin(); p != import_stamps.end(); ) {
+    if (chrono::duration<double>(now - p->second).count() >= bal_migration_hysteresis)
+      p = import_stamps.erase(p);
+    else
+      ++p;
+  }
+
   // We can use duration_cast below, although the result is an int,
   // because the values from g_conf are also integers.
   // balance?
@@ -902,6 +931,7 @@ void MDBalancer::try_rebalance(balance_state_t& state)
   // make a sorted list of my imports
   multimap<double, CDir*> import_pop_map;
   multimap<mds_rank_t, pair<CDir*, double> > import_from_map;
+  time now = clock::now();
 
   for (auto& dir : mds->mdcache->get_fullauth_subtrees()) {
     CInode *diri = dir->get_inode();
@@ -911,6 +941,10 @@ void MDBalancer::try_rebalance(balance_state_t& state)
       continue;
     if (dir->is_freezing() || dir->is_frozen())
       continue;  // export pbly already in progress
+    if (is_recently_imported(dir, now)) {
+      dout(10) << " skipping recently imported " << *dir << dendl;
+      continue;  // let it settle before moving it again
+    }
 
     mds_rank_t from = diri->authority().first;
     double pop = dir->pop_auth_subtree.meta_load();
@@ -1229,6 +1263,42 @@ void MDBalancer::maybe_fragment(CDir *dir, bool hot)
   }
 }
 
+bool MDBalancer::predict_hot(CDir *dir, int type, double v)
+{
+  double threshold;
+  if (type == META_POP_IRD)
+    threshold = g_conf()->mds_bal_split_rd;
+  else if (type == META_POP_IWR)
+    threshold = g_conf()->mds_bal_split_wr;
+  else
+    return false;
+
+  // only follow fragments that are already warming up
+  if (v < threshold / 2)
+    return false;
+
+  double now = chrono::duration<double>(clock::now().time_since_epoch()).count();
+  auto& trend = frag_trends[std::make_pair(dir->dirfrag(), type)];
+  trend.sample(now, v);
+  double predicted = trend.predict(bal_predict_horizon);
+  if (predicted <= threshold)
+    return false;
+
+  dout(10) << "predicted " << type << " pop " << predicted << " in "
+           << bal_predict_horizon << "s (now " << v << ", trend "
+           << trend.get_trend() << "/s) for " << *dir << dendl;
+  return true;
+}
+
+bool MDBalancer::is_recently_imported(CDir *dir, time now) const
+{
+  if (bal_migration_hysteresis <= 0)
+    return false;
+  auto it = import_stamps.find(dir->dirfrag());
+  return it != import_stamps.end() &&
+    chrono::duration<double>(now - it->second).count() < bal_migration_hysteresis;
+}
+
 void MDBalancer::hit_dir(CDir *dir, int type, int who, double amount)
 {
   if (dir->inode->is_stray())
@@ -1236,8 +1306,10 @@ void MDBalancer::hit_dir(CDir *dir, int type, int who, double amount)
   // hit me
   double v = dir->pop_me.get(type).hit(amount);
 
-  const bool hot = (v > g_conf()->mds_bal_split_rd && type == META_POP_IRD) ||
-                   (v > g_conf()->mds_bal_split_wr && type == META_POP_IWR);
+  bool hot = (v > g_conf()->mds_bal_split_rd && type == META_POP_IRD) ||
+             (v > g_conf()->mds_bal_split_wr && type == META_POP_IWR);
+  if (!hot && bal_predict_horizon > 0)
+    hot = predict_hot(dir, type, v);
 
   dout(20) << type << " pop is " << v << ", frag " << dir->get_frag()
            << " size " << dir->get_frag_size() << " " << dir->pop_me << dendl;
@@ -1356,6 +1428,9 @@ void MDBalancer::add_import(CDir *dir)
 {
   dirfrag_load_vec_t subload = dir->pop_auth_subtree;
 
+  if (bal_migration_hysteresis > 0)
+    import_stamps[dir->dirfrag()] = clock::now();
+
   while (true) {
     dir = dir->inode->get_parent_dir();
     if (!dir) break;
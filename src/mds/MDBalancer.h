@@ -22,6 +22,7 @@
 #include "messages/MHeartbeat.h"
 
 #include "MDSMap.h"
+#include "LoadTrend.h"
 
 class MDSRank;
 class MHeartbeat;
@@ -118,8 +119,22 @@ private:
    */
   void try_rebalance(balance_state_t& state);
 
+  /**
+   * Whether the short-term trend of this dirfrag's popularity says it
+   * will cross the split threshold within mds_bal_predict_horizon.
+   */
+  bool predict_hot(CDir *dir, int type, double v);
+
+  /**
+   * Whether this subtree was imported less than
+   * mds_bal_migration_hysteresis seconds ago.
+   */
+  bool is_recently_imported(CDir *dir, time now) const;
+
   bool bal_fragment_dirs;
   int64_t bal_fragment_interval;
+  double bal_predict_horizon;
+  double bal_migration_hysteresis;
   static const unsigned int AUTH_TREES_THRESHOLD = 5;
 
   MDSRank *mds;
@@ -146,6 +161,11 @@ private:
   // dirfrags that already have one in flight.
   std::set<dirfrag_t> split_pending, merge_pending;
 
+  // load trends of warm dirfrags, per popularity type
+  std::map<std::pair<dirfrag_t, int>, LoadTrend> frag_trends;
+  // when subtrees were last imported, to avoid bouncing them right back
+  std::map<dirfrag_t, time> import_stamps;
+
   // per-epoch scatter/gathered info
   std::map<mds_rank_t, mds_load_t> mds_load;
   std::map<mds_rank_t, double> mds_meta_load;
@@ -69,6 +69,10 @@ void MDLog::create_logger()
   plb.add_u64_counter(l_mdl_replayed, "replayed", "Events replayed",
 		      "repl", PerfCountersBuilder::PRIO_INTERESTING);
   plb.add_time_avg(l_mdl_jlat, "jlat", "Journaler flush latency");
+  plb.add_u64_avg(l_mdl_evbatch, "evbatch",
+                  "Events encoded and appended per submit batch");
+  plb.add_time_avg(l_mdl_encode_lat, "encode_lat",
+                   "Time spent encoding a submit batch");
   plb.add_u64_counter(l_mdl_evex, "evex", "Total expired events");
   plb.add_u64_counter(l_mdl_evtrm, "evtrm", "Trimmed events");
   plb.add_u64_counter(l_mdl_segadd, "segadd", "Segments added");
@@ -358,6 +362,9 @@ void MDLog::_submit_thread()
 
   std::unique_lock locker{submit_mutex};
 
+  std::vector<PendingEvent> batch;
+  std::vector<bufferlist> encoded;
+
   while (!mds->is_daemon_stopping()) {
     if (g_conf()->mds_log_pause) {
       submit_cond.wait(locker);
@@ -375,68 +382,94 @@ void MDLog::_submit_thread()
       continue;
     }
 
+    // take as many events of this segment as we are allowed in one go so
+    // that submit_mutex is cycled once per batch rather than once per event.
+    const auto max_batch = std::max<uint64_t>(1,
+        g_conf().get_val<uint64_t>("mds_log_max_submit_batch"));
     int64_t features = mdsmap_up_features;
-    PendingEvent data = it->second.front();
-    it->second.pop_front();
+    batch.clear();
+    while (!it->second.empty() && batch.size() < max_batch) {
+      batch.push_back(it->second.front());
+      it->second.pop_front();
+    }
 
     locker.unlock();
 
-    if (data.le) {
-      LogEvent *le = data.le;
-      LogSegment *ls = le->_segment;
-      // encode it, with event type
-      bufferlist bl;
-      le->encode_with_header(bl, features);
+    // encode the whole batch up front, before touching the journaler
+    auto encode_start = mono_clock::now();
+    unsigned num_le = 0;
+    encoded.resize(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+      if (batch[i].le) {
+	batch[i].le->encode_with_header(encoded[i], features);
+	num_le++;
+      }
+    }
+    if (logger && num_le) {
+      logger->tinc(l_mdl_encode_lat, mono_clock::now() - encode_start);
+      logger->inc(l_mdl_evbatch, num_le);
+    }
 
-      uint64_t write_pos = journaler->get_write_pos();
+    for (size_t i = 0; i < batch.size(); ++i) {
+      PendingEvent &data = batch[i];
+      if (data.le) {
+	LogEvent *le = data.le;
+	LogSegment *ls = le->_segment;
+	bufferlist &bl = encoded[i];
 
-      le->set_start_off(write_pos);
-      if (le->get_type() == EVENT_SUBTREEMAP)
-	ls->offset = write_pos;
+	uint64_t write_pos = journaler->get_write_pos();
 
-      dout(5) << "_submit_thread " << write_pos << "~" << bl.length()
-	      << " : " << *le << dendl;
+	le->set_start_off(write_pos);
+	if (le->get_type() == EVENT_SUBTREEMAP)
+	  ls->offset = write_pos;
 
-      // journal it.
-      const uint64_t new_write_pos = journaler->append_entry(bl);  // bl is destroyed.
-      ls->end = new_write_pos;
+	dout(5) << "_submit_thread " << write_pos << "~" << bl.length()
+		<< " : " << *le << dendl;
 
-      MDSLogContextBase *fin;
-      if (data.fin) {
-	fin = dynamic_cast<MDSLogContextBase*>(data.fin);
-	ceph_assert(fin);
-	fin->set_write_pos(new_write_pos);
-      } else {
-	fin = new C_MDL_Flushed(this, new_write_pos);
-      }
+	// journal it.
+	const uint64_t new_write_pos = journaler->append_entry(bl);  // bl is destroyed.
+	ls->end = new_write_pos;
 
-      journaler->wait_for_flush(fin);
+	MDSLogContextBase *fin;
+	if (data.fin) {
+	  fin = dynamic_cast<MDSLogContextBase*>(data.fin);
+	  ceph_assert(fin);
+	  fin->set_write_pos(new_write_pos);
+	} else {
+	  fin = new C_MDL_Flushed(this, new_write_pos);
+	}
 
-      if (data.flush)
-	journaler->flush();
+	journaler->wait_for_flush(fin);
 
-      if (logger)
-	logger->set(l_mdl_wrpos, ls->end);
+	if (data.flush)
+	  journaler->flush();
 
-      delete le;
-    } else {
-      if (data.fin) {
-	MDSContext* fin =
-		dynamic_cast<MDSContext*>(data.fin);
-	ceph_assert(fin);
-	C_MDL_Flushed *fin2 = new C_MDL_Flushed(this, fin);
-	fin2->set_write_pos(journaler->get_write_pos());
-	journaler->wait_for_flush(fin2);
+	if (logger)
+	  logger->set(l_mdl_wrpos, ls->end);
+
+	delete le;
+      } else {
+	if (data.fin) {
+	  MDSContext* fin =
+		  dynamic_cast<MDSContext*>(data.fin);
+	  ceph_assert(fin);
+	  C_MDL_Flushed *fin2 = new C_MDL_Flushed(this, fin);
+	  fin2->set_write_pos(journaler->get_write_pos());
+	  journaler->wait_for_flush(fin2);
+	}
+	if (data.flush)
+	  journaler->flush();
       }
-      if (data.flush)
-	journaler->flush();
+      encoded[i].clear();
     }
 
     locker.lock();
-    if (data.flush)
-      unflushed = 0;
-    else if (data.le)
-      unflushed++;
+    for (const auto &data : batch) {
+      if (data.flush)
+	unflushed = 0;
+      else if (data.le)
+	unflushed++;
+    }
   }
 }
 
@@ -1302,9 +1335,42 @@ void MDLog::_replay_thread()
 {
   dout(10) << "_replay_thread start" << dendl;
 
+  replay_start_pos = journaler->get_read_pos();
+  replay_start = mono_clock::now();
+  replayed_events = 0;
+
+  // read and decode a window of events without mds_lock, then apply them
+  // in order under a single lock hold instead of taking it per event.
+  const uint64_t max_batch = std::max<uint64_t>(1,
+      g_conf().get_val<uint64_t>("mds_replay_batch_events"));
+  std::vector<std::unique_ptr<LogEvent>> batch;
+  batch.reserve(max_batch);
+  auto replay_batch = [&]() {
+    if (batch.empty())
+      return true;
+    std::lock_guard l(mds->mds_lock);
+    if (mds->is_daemon_stopping())
+      return false;
+    for (auto& le : batch) {
+      logger->inc(l_mdl_replayed);
+      le->replay(mds);
+    }
+    replayed_events += batch.size();
+    batch.clear();
+    return true;
+  };
+
   // loop
   int r = 0;
   while (1) {
+    // apply what we have before blocking on the journal or bailing out
+    if (batch.size() >= max_batch ||
+	!journaler->is_readable() ||
+	journaler->get_error()) {
+      if (!replay_batch())
+	return;
+    }
+
     // wait for read?
     while (!journaler->is_readable() &&
 	   journaler->get_read_pos() < journaler->get_write_pos() &&
@@ -1411,6 +1477,9 @@ void MDLog::_replay_thread()
     // new segment?
     if (le->get_type() == EVENT_SUBTREEMAP ||
 	le->get_type() == EVENT_RESETJOURNAL) {
+      // queued events must see their own segment as the current one
+      if (!replay_batch())
+	return;
       auto sle = dynamic_cast<ESubtreeMap*>(le.get());
       if (sle && sle->event_seq > 0)
 	event_seq = sle->event_seq;
@@ -1434,19 +1503,15 @@ void MDLog::_replay_thread()
       le->_segment->end = journaler->get_read_pos();
       num_events++;
 
-      {
-        std::lock_guard l(mds->mds_lock);
-        if (mds->is_daemon_stopping()) {
-          return;
-        }
-        logger->inc(l_mdl_replayed);
-        le->replay(mds);
-      }
+      batch.push_back(std::move(le));
     }
 
     logger->set(l_mdl_rdpos, pos);
   }
 
+  if (!replay_batch())
+    return;
+
   // done!
   if (r == 0) {
     ceph_assert(journaler->get_read_pos() == journaler->get_write_pos());
@@ -1517,5 +1582,18 @@ void MDLog::dump_replay_status(Formatter *f) const
   f->dump_unsigned("journal_expire_pos", journaler ? journaler->get_expire_pos() : 0);
   f->dump_unsigned("num_events", get_num_events());
   f->dump_unsigned("num_segments", get_num_segments());
+  if (journaler) {
+    uint64_t read_pos = journaler->get_read_pos();
+    uint64_t write_pos = journaler->get_write_pos();
+    uint64_t replayed = read_pos > replay_start_pos ? read_pos - replay_start_pos : 0;
+    uint64_t total = write_pos > replay_start_pos ? write_pos - replay_start_pos : 0;
+    double elapsed = std::chrono::duration<double>(mono_clock::now() - replay_start).count();
+    f->dump_unsigned("replayed_events", replayed_events);
+    f->dump_unsigned("replayed_bytes", replayed);
+    f->dump_float("elapsed", elapsed);
+    f->dump_float("bytes_per_sec", elapsed > 0 ? replayed / elapsed : 0);
+    f->dump_float("events_per_sec", elapsed > 0 ? replayed_events / elapsed : 0);
+    f->dump_float("percent_complete", total ? 100.0 * replayed / total : 100.0);
+  }
   f->close_section();
 }
@@ -35,6 +35,8 @@ enum {
   l_mdl_rdpos,
   l_mdl_jlat,
   l_mdl_replayed,
+  l_mdl_evbatch,
+  l_mdl_encode_lat,
   l_mdl_last,
 };
 
@@ -280,6 +282,11 @@ protected:
   std::set<LogSegment*> expired_segments;
   std::size_t pre_segments_size = 0;            // the num of segments when the mds finished replay-journal, to calc the num of segments growing
   uint64_t event_seq = 0;
+
+  // replay progress, reported by dump_replay_status()
+  uint64_t replay_start_pos = 0;
+  mono_time replay_start;
+  uint64_t replayed_events = 0;
   int expiring_events = 0;
   int expired_events = 0;
 
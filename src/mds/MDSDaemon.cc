@@ -906,11 +906,19 @@ void MDSDaemon::respawn()
 
 bool MDSDaemon::ms_dispatch2(const ref_t<Message> &m)
 {
+  auto lock_start = mono_clock::now();
   std::lock_guard l(mds_lock);
   if (stopping) {
     return false;
   }
 
+  // Every message, read-only or not, serializes on mds_lock; track how
+  // long dispatch waits for it so contention is visible in perf dump.
+  if (mds_rank && mds_rank->logger) {
+    mds_rank->logger->tinc(l_mds_dispatch_lock_wait,
+                           mono_clock::now() - lock_start);
+  }
+
   // Drop out early if shutting down
   if (beacon.get_want_state() == CEPH_MDS_STATE_DNE) {
     dout(10) << " stopping, discarding " << *m << dendl;
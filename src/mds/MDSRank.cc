@@ -1030,9 +1030,12 @@ bool MDSRankDispatcher::ms_dispatch(const cref_t<Message> &m)
       session->last_seen = Session::clock::now();
   }
 
+  auto start = mono_clock::now();
   inc_dispatch_depth();
   bool ret = _dispatch(m, true);
   dec_dispatch_depth();
+  if (logger)
+    logger->tinc(l_mds_dispatch_time, mono_clock::now() - start);
   return ret;
 }
 
@@ -3364,6 +3367,10 @@ void MDSRank::create_logger()
     mds_plb.add_u64_counter(l_mds_traverse_lock, "traverse_lock",
                             "Traverse locks");
     mds_plb.add_u64(l_mds_dispatch_queue_len, "q", "Dispatch queue length");
+    mds_plb.add_time_avg(l_mds_dispatch_lock_wait, "dispatch_lock_wait",
+                         "Time spent waiting for mds_lock before dispatching a message");
+    mds_plb.add_time_avg(l_mds_dispatch_time, "dispatch_time",
+                         "Time spent dispatching a message under mds_lock");
     mds_plb.add_u64_counter(l_mds_exported, "exported", "Exports");
     mds_plb.add_u64_counter(l_mds_imported, "imported", "Imports");
     mds_plb.add_u64_counter(l_mds_openino_backtrace_fetch, "openino_backtrace_fetch",
@@ -3672,6 +3679,8 @@ const char** MDSRankDispatcher::get_tracked_conf_keys() const
     "host",
     "mds_bal_fragment_dirs",
     "mds_bal_fragment_interval",
+    "mds_bal_migration_hysteresis",
+    "mds_bal_predict_horizon",
     "mds_cache_memory_limit",
     "mds_cache_mid",
     "mds_cache_reservation",
@@ -108,6 +108,7 @@ enum {
   l_osdc_op_send,
   l_osdc_op_send_bytes,
   l_osdc_op_resend,
+  l_osdc_op_send_batched,
   l_osdc_op_reply,
   l_osdc_oplen_avg,
 
@@ -216,6 +217,8 @@ const char** Objecter::get_tracked_conf_keys() const
     "crush_location",
     "rados_mon_op_timeout",
     "rados_osd_op_timeout",
+    "objecter_op_batch_window_us",
+    "objecter_op_batch_max_ops",
     NULL
   };
   return config_keys;
@@ -234,6 +237,12 @@ void Objecter::handle_conf_change(const ConfigProxy& conf,
   if (changed.count("rados_osd_op_timeout")) {
     osd_timeout = conf.get_val<std::chrono::seconds>("rados_osd_op_timeout");
   }
+  if (changed.count("objecter_op_batch_window_us")) {
+    op_batch_window_us = conf.get_val<uint64_t>("objecter_op_batch_window_us");
+  }
+  if (changed.count("objecter_op_batch_max_ops")) {
+    op_batch_max_ops = conf.get_val<uint64_t>("objecter_op_batch_max_ops");
+  }
 }
 
 void Objecter::update_crush_location()
@@ -260,6 +269,8 @@ void Objecter::init()
     pcb.add_u64_counter(l_osdc_op_send, "op_send", "Sent operations");
     pcb.add_u64_counter(l_osdc_op_send_bytes, "op_send_bytes", "Sent data", NULL, 0, unit_t(UNIT_BYTES));
     pcb.add_u64_counter(l_osdc_op_resend, "op_resend", "Resent operations");
+    pcb.add_u64_counter(l_osdc_op_send_batched, "op_send_batched",
+			"Operations sent as part of a batch");
     pcb.add_u64_counter(l_osdc_op_reply, "op_reply", "Operation reply");
     pcb.add_u64_avg(l_osdc_oplen_avg, "oplen_avg", "Average length of operation vector");
 
@@ -1891,6 +1902,9 @@ void Objecter::_reopen_session(OSDSession *s)
   auto addrs = osdmap->get_addrs(s->osd);
   ldout(cct, 10) << "reopen_session osd." << s->osd << " session, addr now "
 		 << addrs << dendl;
+  // anything still batched was encoded for the old connection; those ops
+  // are resent by _kick_requests
+  _discard_batched_msgs(s);
   if (s->con) {
     s->con->set_priv(NULL);
     s->con->mark_down();
@@ -1913,6 +1927,7 @@ void Objecter::close_session(OSDSession *s)
     logger->inc(l_osdc_osd_session_close);
   }
   unique_lock sl(s->lock);
+  _discard_batched_msgs(s);
 
   std::list<LingerOp*> homeless_lingers;
   std::list<CommandOp*> homeless_commands;
@@ -3300,7 +3315,74 @@ void Objecter::_send_op(Op *op)
   if (op->trace.valid()) {
     m->trace.init("op msg", nullptr, &op->trace);
   }
-  op->session->con->send_message(m);
+  if (op_batch_window_us > 0 && op_batch_max_ops > 1) {
+    _batch_op_message(op->session, m);
+  } else {
+    // batching may have been turned off with ops still held back; send
+    // those first to keep per-object ordering
+    if (!op->session->op_batch.empty()) {
+      _flush_batched_msgs(op->session);
+    }
+    op->session->con->send_message(m);
+  }
+}
+
+void Objecter::_batch_op_message(OSDSession *s, MOSDOp *m)
+{
+  // s->lock is locked unique
+
+  s->op_batch.push(m);
+  if (s->op_batch.size() >= op_batch_max_ops) {
+    _flush_batched_msgs(s);
+    return;
+  }
+  if (!s->op_batch.is_armed()) {
+    s->get();
+    s->op_batch.arm(
+      timer, std::chrono::microseconds(op_batch_window_us.load()),
+      [this, s](OpBatch<MOSDOp>::event_ref id) {
+	std::unique_lock sl(s->lock);
+	// a flush may have raced with us and re-armed the batch
+	if (s->op_batch.fired(id)) {
+	  _flush_batched_msgs(s);
+	}
+	sl.unlock();
+	s->put();
+      });
+  }
+}
+
+void Objecter::_flush_batched_msgs(OSDSession *s)
+{
+  // s->lock is locked unique
+
+  if (s->op_batch.disarm(timer)) {
+    s->put();
+  }
+  if (s->op_batch.empty()) {
+    return;
+  }
+  auto msgs = s->op_batch.take();
+  ldout(cct, 20) << __func__ << " osd." << s->osd << " sending "
+		 << msgs.size() << " ops" << dendl;
+  // queue the whole batch back to back so the messenger coalesces them
+  // into as few socket writes as possible
+  logger->inc(l_osdc_op_send_batched, msgs.size());
+  for (auto m : msgs) {
+    s->con->send_message(m);
+  }
+}
+
+void Objecter::_discard_batched_msgs(OSDSession *s)
+{
+  // s->lock is locked unique
+
+  if (s->op_batch.disarm(timer)) {
+    s->put();
+  }
+  for (auto m : s->op_batch.take()) {
+    m->put();
+  }
 }
 
 int Objecter::calc_op_budget(const bc::small_vector_base<OSDOp>& ops)
@@ -4994,6 +5076,8 @@ Objecter::Objecter(CephContext *cct,
 {
   mon_timeout = cct->_conf.get_val<std::chrono::seconds>("rados_mon_op_timeout");
   osd_timeout = cct->_conf.get_val<std::chrono::seconds>("rados_osd_op_timeout");
+  op_batch_window_us = cct->_conf.get_val<uint64_t>("objecter_op_batch_window_us");
+  op_batch_max_ops = cct->_conf.get_val<uint64_t>("objecter_op_batch_max_ops");
 }
 
 Objecter::~Objecter()
@@ -57,6 +57,7 @@
 #include "msg/Dispatcher.h"
 
 #include "osd/OSDMap.h"
+#include "osdc/OpBatch.h"
 
 class Context;
 class Messenger;
@@ -1672,25 +1673,46 @@ private:
                : epoch(epoch), up(up), up_primary(up_primary),
                  acting(acting), acting_primary(acting_primary) {}
   };
-  ceph::shared_mutex pg_mapping_lock =
-    ceph::make_shared_mutex("Objecter::pg_mapping_lock");
-  // pool -> pg mapping
-  std::map<int64_t, std::vector<pg_mapping_t>> pg_mappings;
+  // The pg mapping cache is consulted by every _calc_target() call, so
+  // it is striped across a fixed number of shards (by placement seed) to
+  // keep concurrent submitters from bouncing a single lock cache line.
+  static constexpr unsigned PG_MAPPING_SHARDS = 16;
+  struct alignas(64) pg_mapping_shard_t {
+    ceph::shared_mutex lock =
+      ceph::make_shared_mutex("Objecter::pg_mapping_shard_t::lock");
+    // pool -> pg mapping (indexed by ps / PG_MAPPING_SHARDS)
+    std::map<int64_t, std::vector<pg_mapping_t>> pg_mappings;
+  };
+  pg_mapping_shard_t pg_mapping_shards[PG_MAPPING_SHARDS];
+
+  static unsigned pg_mapping_shard_index(ps_t ps) {
+    return ps % PG_MAPPING_SHARDS;
+  }
+  static size_t pg_mapping_slot(ps_t ps) {
+    return ps / PG_MAPPING_SHARDS;
+  }
+  static size_t pg_mapping_slots(unsigned shard, size_t pg_num) {
+    // number of seeds in [0, pg_num) that land on this shard
+    return pg_num / PG_MAPPING_SHARDS +
+      (shard < pg_num % PG_MAPPING_SHARDS ? 1 : 0);
+  }
 
   // convenient accessors
   bool lookup_pg_mapping(const pg_t& pg, epoch_t epoch, std::vector<int> *up,
                          int *up_primary, std::vector<int> *acting,
                          int *acting_primary) {
-    std::shared_lock l{pg_mapping_lock};
-    auto it = pg_mappings.find(pg.pool());
-    if (it == pg_mappings.end())
+    auto& shard = pg_mapping_shards[pg_mapping_shard_index(pg.ps())];
+    std::shared_lock l{shard.lock};
+    auto it = shard.pg_mappings.find(pg.pool());
+    if (it == shard.pg_mappings.end())
       return false;
     auto& mapping_array = it->second;
-    if (pg.ps() >= mapping_array.size())
+    auto slot = pg_mapping_slot(pg.ps());
+    if (slot >= mapping_array.size())
       return false;
-    if (mapping_array[pg.ps()].epoch != epoch) // stale
+    if (mapping_array[slot].epoch != epoch) // stale
       return false;
-    auto& pg_mapping = mapping_array[pg.ps()];
+    auto& pg_mapping = mapping_array[slot];
     *up = pg_mapping.up;
     *up_primary = pg_mapping.up_primary;
     *acting = pg_mapping.acting;
@@ -1698,28 +1720,34 @@ private:
     return true;
   }
   void update_pg_mapping(const pg_t& pg, pg_mapping_t&& pg_mapping) {
-    std::lock_guard l{pg_mapping_lock};
-    auto& mapping_array = pg_mappings[pg.pool()];
-    ceph_assert(pg.ps() < mapping_array.size());
-    mapping_array[pg.ps()] = std::move(pg_mapping);
+    auto& shard = pg_mapping_shards[pg_mapping_shard_index(pg.ps())];
+    std::lock_guard l{shard.lock};
+    auto& mapping_array = shard.pg_mappings[pg.pool()];
+    auto slot = pg_mapping_slot(pg.ps());
+    ceph_assert(slot < mapping_array.size());
+    mapping_array[slot] = std::move(pg_mapping);
   }
   void prune_pg_mapping(const mempool::osdmap::map<int64_t,pg_pool_t>& pools) {
-    std::lock_guard l{pg_mapping_lock};
-    for (auto& pool : pools) {
-      auto& mapping_array = pg_mappings[pool.first];
-      size_t pg_num = pool.second.get_pg_num();
-      if (mapping_array.size() != pg_num) {
-        // catch both pg_num increasing & decreasing
-        mapping_array.resize(pg_num);
+    for (unsigned i = 0; i < PG_MAPPING_SHARDS; ++i) {
+      auto& shard = pg_mapping_shards[i];
+      std::lock_guard l{shard.lock};
+      for (auto& pool : pools) {
+        auto& mapping_array = shard.pg_mappings[pool.first];
+        size_t slots = pg_mapping_slots(i, pool.second.get_pg_num());
+        if (mapping_array.size() != slots) {
+          // catch both pg_num increasing & decreasing
+          mapping_array.resize(slots);
+        }
       }
-    }
-    for (auto it = pg_mappings.begin(); it != pg_mappings.end(); ) {
-      if (!pools.count(it->first)) {
-        // pool is gone
-        pg_mappings.erase(it++);
-        continue;
+      for (auto it = shard.pg_mappings.begin();
+           it != shard.pg_mappings.end(); ) {
+        if (!pools.count(it->first)) {
+          // pool is gone
+          shard.pg_mappings.erase(it++);
+          continue;
+        }
+        it++;
       }
-      it++;
     }
   }
 
@@ -2391,6 +2419,8 @@ public:
 
     int incarnation;
     ConnectionRef con;
+    // encoded ops held back briefly so they reach con as a single burst
+    OpBatch<MOSDOp> op_batch;
     int num_locks;
     std::unique_ptr<std::mutex[]> completion_locks;
 
@@ -2449,9 +2479,14 @@ public:
 
   ceph::timespan mon_timeout;
   ceph::timespan osd_timeout;
+  std::atomic<uint64_t> op_batch_window_us{0};
+  std::atomic<uint64_t> op_batch_max_ops{0};
 
   MOSDOp *_prepare_osd_op(Op *op);
   void _send_op(Op *op);
+  void _batch_op_message(OSDSession *s, MOSDOp *m);
+  void _flush_batched_msgs(OSDSession *s);
+  void _discard_batched_msgs(OSDSession *s);
   void _send_op_account(Op *op);
   void _cancel_linger_op(Op *op);
   void _finish_op(Op *op, int r);
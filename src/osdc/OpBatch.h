@@ -0,0 +1,107 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#ifndef CEPH_OSDC_OPBATCH_H
+#define CEPH_OSDC_OPBATCH_H
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * Encoded messages held back for one OSD session until a short send window
+ * closes, plus the timer event that closes it.
+ *
+ * The owner serializes all calls with its own lock, and the timer callback
+ * must take that same lock before calling fired().  A callback that was
+ * already running when the batch got flushed (so cancel_event() failed) may
+ * then find the batch re-armed with a newer event; fired() tells it apart
+ * so it leaves the newer event alone.
+ */
+template <typename Msg>
+class OpBatch {
+public:
+  /// id of an armed event; only valid once arm() has returned
+  using event_ref = std::shared_ptr<const uint64_t>;
+
+  void push(Msg *m) {
+    msgs.push_back(m);
+  }
+  size_t size() const {
+    return msgs.size();
+  }
+  bool empty() const {
+    return msgs.empty();
+  }
+  bool is_armed() const {
+    return flush_event != 0;
+  }
+  uint64_t get_flush_event() const {
+    return flush_event;
+  }
+
+  /**
+   * Schedule @cb on @timer after @delay.  The callback is invoked as cb(id)
+   * with a reference to the id of the event that fired.  The event may fire
+   * before add_event() even returns, so the id must only be read under the
+   * owner's lock, i.e. by passing it to fired().
+   */
+  template <typename Timer, typename Duration, typename Callback>
+  void arm(Timer& timer, Duration delay, Callback&& cb) {
+    auto id = std::make_shared<uint64_t>(0);
+    *id = timer.add_event(
+      delay,
+      [id, cb = std::forward<Callback>(cb)]() mutable {
+	cb(event_ref{id});
+      });
+    flush_event = *id;
+  }
+
+  /**
+   * The timer event @id fired.
+   *
+   * @returns true if it is still the current flush event, which is then
+   *  cleared and the caller should flush; false if the batch was flushed or
+   *  re-armed in the meantime
+   */
+  bool fired(const event_ref& id) {
+    if (flush_event != *id) {
+      return false;
+    }
+    flush_event = 0;
+    return true;
+  }
+
+  /**
+   * Cancel the pending flush event, if any.
+   *
+   * @returns true if the event was cancelled before it ran, i.e. its
+   *  callback will never run
+   */
+  template <typename Timer>
+  bool disarm(Timer& timer) {
+    auto id = std::exchange(flush_event, 0);
+    return id && timer.cancel_event(id);
+  }
+
+  /// hand over the batched messages, oldest first
+  std::vector<Msg*> take() {
+    return std::exchange(msgs, {});
+  }
+
+private:
+  std::vector<Msg*> msgs;
+  uint64_t flush_event = 0;
+};
+
+#endif
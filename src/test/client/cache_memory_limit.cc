@@ -0,0 +1,63 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <fmt/format.h>
+
+#include "test/client/TestClient.h"
+
+TEST_F(TestClient, CacheMemoryLimit) {
+  auto dir = fmt::format("{}_{}", ::testing::UnitTest::GetInstance()->current_test_info()->name(), getpid());
+  ASSERT_EQ(0, client->mkdir(dir.c_str(), 0777, myperm));
+
+  constexpr int nfiles = 256;
+  auto path = [&dir](int i) {
+    return fmt::format("{}/file{}", dir, i);
+  };
+  for (int i = 0; i < nfiles; ++i) {
+    int fd = client->open(path(i).c_str(), O_CREAT|O_WRONLY, myperm, 0666);
+    ASSERT_LE(0, fd);
+    ASSERT_EQ(0, client->close(fd));
+  }
+  uint64_t unlimited = client->get_cache_bytes();
+
+  // cap the cache well below what the files use and look them up again
+  uint64_t limit = unlimited / 4;
+  g_ceph_context->_conf.set_val_or_die("client_cache_memory_limit",
+                                       std::to_string(limit));
+  for (int i = 0; i < nfiles; ++i) {
+    int fd = client->open(path(i).c_str(), O_RDONLY, myperm);
+    ASSERT_LE(0, fd);
+    ASSERT_EQ(0, client->close(fd));
+  }
+
+  // evicted inodes are freed by the next tick
+  for (int i = 0; i < 30 && client->get_cache_bytes() > limit; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  }
+  uint64_t limited = client->get_cache_bytes();
+  g_ceph_context->_conf.set_val_or_die("client_cache_memory_limit", "0");
+
+  ASSERT_LE(limited, limit);
+
+  for (int i = 0; i < nfiles; ++i) {
+    ASSERT_EQ(0, client->unlink(path(i).c_str(), myperm));
+  }
+  ASSERT_EQ(0, client->rmdir(dir.c_str(), myperm));
+}
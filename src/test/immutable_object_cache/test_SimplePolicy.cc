@@ -233,3 +233,27 @@ TEST_F(TestSimplePolicy, test_evict_list_10) {
     m_promoted_lru.erase(m_promoted_lru.begin());
   }
 }
+
+TEST_F(TestSimplePolicy, test_hit_promotes_to_protected) {
+  ASSERT_EQ(0u, m_simple_policy->get_protected_entry_num());
+  ASSERT_EQ(OBJ_CACHE_PROMOTED,
+            m_simple_policy->lookup_object(generate_file_name(0)));
+  ASSERT_EQ(1u, m_simple_policy->get_protected_entry_num());
+  ASSERT_EQ(m_promoted_lru.size(), m_simple_policy->get_promoted_entry_num());
+
+  // entries hit only once are evicted first
+  ASSERT_EQ(generate_file_name(1), m_simple_policy->get_evict_entry());
+  m_promoted_lru.erase(m_promoted_lru.begin());
+  m_promoted_lru.push_back(generate_file_name(0));
+}
+
+TEST_F(TestSimplePolicy, test_protected_segment_is_bounded) {
+  for (uint64_t index = 0; index < m_entry_index; index++) {
+    ASSERT_EQ(OBJ_CACHE_PROMOTED,
+              m_simple_policy->lookup_object(generate_file_name(index)));
+  }
+  // 80% of the entries stay protected, the coldest ones were demoted
+  ASSERT_EQ(m_promoted_lru.size() * 4 / 5,
+            m_simple_policy->get_protected_entry_num());
+  ASSERT_EQ(m_promoted_lru.size(), m_simple_policy->get_promoted_entry_num());
+}
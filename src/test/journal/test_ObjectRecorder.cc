@@ -8,7 +8,9 @@
 #include "gtest/gtest.h"
 #include "test/librados/test.h"
 #include "test/journal/RadosTestFixture.h"
+#include <algorithm>
 #include <limits>
+#include <vector>
 
 using namespace std::chrono_literals;
 using std::shared_ptr;
@@ -23,6 +25,7 @@ public:
     ceph::condition_variable cond;
     bool is_closed = false;
     uint32_t overflows = 0;
+    bool claim_on_overflow = true;
 
     Handler() = default;
 
@@ -33,10 +36,12 @@ public:
     }
     void overflow(journal::ObjectRecorder *object_recorder) override {
       std::lock_guard locker{lock};
-      journal::AppendBuffers append_buffers;
-      object_lock->lock();
-      object_recorder->claim_append_buffers(&append_buffers);
-      object_lock->unlock();
+      if (claim_on_overflow) {
+        journal::AppendBuffers append_buffers;
+        object_lock->lock();
+        object_recorder->claim_append_buffers(&append_buffers);
+        object_lock->unlock();
+      }
 
       ++overflows;
       cond.notify_all();
@@ -96,6 +101,10 @@ public:
       return m_handler.cond.wait_for(locker, 10s,
 				     [this] { return m_handler.is_closed; });
     }
+    void set_claim_on_overflow(bool claim_on_overflow) {
+      std::lock_guard locker{m_handler.lock};
+      m_handler.claim_on_overflow = claim_on_overflow;
+    }
     bool wait_for_overflow() {
       std::unique_lock locker{m_handler.lock};
       if (m_handler.cond.wait_for(locker, 10s,
@@ -129,6 +138,55 @@ public:
     bl.append(payload);
     return std::make_pair(future, bl);
   }
+
+  struct CompletionOrder {
+    ceph::mutex lock = ceph::make_mutex("completion_order");
+    std::vector<uint64_t> entry_tids;
+  };
+
+  journal::AppendBuffer create_tracked_append_buffer(
+      uint64_t tag_tid, uint64_t entry_tid, const std::string &payload,
+      CompletionOrder *completion_order) {
+    auto append_buffer = create_append_buffer(tag_tid, entry_tid, payload);
+    append_buffer.first->wait(new LambdaContext(
+      [completion_order, entry_tid](int r) {
+        std::lock_guard locker{completion_order->lock};
+        completion_order->entry_tids.push_back(entry_tid);
+      }));
+    return append_buffer;
+  }
+
+  // seed the append latency estimate with a completed append, then keep
+  // appending single entries until a batch is pipelined behind the append
+  // already in flight. Returns the highest number of in-flight appends seen.
+  size_t append_until_pipelined(journal::ObjectRecorder *object,
+                                ceph::mutex *lock, const std::string &payload,
+                                CompletionOrder *completion_order,
+                                std::vector<journal::AppendBuffer> *appended) {
+    size_t max_in_flight = 0;
+    auto append = [&]() {
+      auto append_buffer = create_tracked_append_buffer(
+        234, 123 + appended->size(), payload, completion_order);
+      appended->push_back(append_buffer);
+
+      journal::AppendBuffers append_buffers = {append_buffer};
+      std::lock_guard locker{*lock};
+      EXPECT_FALSE(object->append(std::move(append_buffers)));
+    };
+
+    append();
+    C_SaferCond cond;
+    appended->back().first->wait(&cond);
+    EXPECT_EQ(0, cond.wait());
+
+    auto end = ceph::mono_clock::now() + 10s;
+    while (max_in_flight < 2 && ceph::mono_clock::now() < end) {
+      append();
+      max_in_flight = std::max(max_in_flight, object->get_in_flight_appends());
+      usleep(100);
+    }
+    return max_in_flight;
+  }
 };
 
 TEST_F(TestObjectRecorder, Append) {
@@ -462,3 +520,158 @@ TEST_F(TestObjectRecorder, Overflow) {
 
   ASSERT_TRUE(flusher.wait_for_overflow());
 }
+
+TEST_F(TestObjectRecorder, AppendPipelined) {
+  std::string oid = get_temp_oid();
+  ASSERT_EQ(0, create(oid));
+  ASSERT_EQ(0, client_register(oid));
+  auto metadata = create_metadata(oid);
+  ASSERT_EQ(0, init_metadata(metadata));
+
+  ceph::mutex lock = ceph::make_mutex("object_recorder_lock");
+  ObjectRecorderFlusher flusher(m_ioctx, m_work_queue, 0, 0, 600, 0);
+  auto object = flusher.create_object(oid, 24, &lock);
+
+  CompletionOrder completion_order;
+  std::vector<journal::AppendBuffer> appended;
+  size_t max_in_flight = append_until_pipelined(object.get(), &lock, "payload",
+                                                &completion_order, &appended);
+  ASSERT_LT(1U, max_in_flight);
+
+  // keep appending while batches are pipelined
+  for (size_t i = 0; i < 256; ++i) {
+    auto append_buffer = create_tracked_append_buffer(
+      234, 123 + appended.size(), "payload", &completion_order);
+    appended.push_back(append_buffer);
+
+    journal::AppendBuffers append_buffers = {append_buffer};
+    lock.lock();
+    ASSERT_FALSE(object->append(std::move(append_buffers)));
+    lock.unlock();
+    ASSERT_GE(4U, object->get_in_flight_appends());
+  }
+
+  C_SaferCond cond;
+  object->flush(&cond);
+  ASSERT_EQ(0, cond.wait());
+  ASSERT_EQ(0U, object->get_pending_appends());
+
+  // futures of pipelined appends still complete in append order
+  for (auto& append_buffer : appended) {
+    ASSERT_TRUE(append_buffer.first->is_complete());
+    ASSERT_EQ(0, append_buffer.first->get_return_value());
+  }
+  std::lock_guard locker{completion_order.lock};
+  ASSERT_EQ(appended.size(), completion_order.entry_tids.size());
+  ASSERT_TRUE(std::is_sorted(completion_order.entry_tids.begin(),
+                             completion_order.entry_tids.end()));
+}
+
+TEST_F(TestObjectRecorder, ClosePipelined) {
+  std::string oid = get_temp_oid();
+  ASSERT_EQ(0, create(oid));
+  ASSERT_EQ(0, client_register(oid));
+  auto metadata = create_metadata(oid);
+  ASSERT_EQ(0, init_metadata(metadata));
+
+  ceph::mutex lock = ceph::make_mutex("object_recorder_lock");
+  ObjectRecorderFlusher flusher(m_ioctx, m_work_queue, 0, 0, 600, 0);
+  auto object = flusher.create_object(oid, 24, &lock);
+
+  CompletionOrder completion_order;
+  std::vector<journal::AppendBuffer> appended;
+  size_t max_in_flight = append_until_pipelined(object.get(), &lock, "payload",
+                                                &completion_order, &appended);
+  ASSERT_LT(1U, max_in_flight);
+
+  // close sends the pending batch and waits for every in-flight append
+  lock.lock();
+  bool closed = object->close();
+  lock.unlock();
+  if (!closed) {
+    ASSERT_TRUE(flusher.wait_for_closed());
+  }
+  ASSERT_EQ(0U, object->get_pending_appends());
+  ASSERT_EQ(0U, object->get_in_flight_appends());
+
+  for (auto& append_buffer : appended) {
+    C_SaferCond cond;
+    append_buffer.first->wait(&cond);
+    ASSERT_EQ(0, cond.wait());
+  }
+  std::lock_guard locker{completion_order.lock};
+  ASSERT_EQ(appended.size(), completion_order.entry_tids.size());
+  ASSERT_TRUE(std::is_sorted(completion_order.entry_tids.begin(),
+                             completion_order.entry_tids.end()));
+}
+
+TEST_F(TestObjectRecorder, OverflowPipelined) {
+  std::string oid = get_temp_oid();
+  ASSERT_EQ(0, create(oid));
+  ASSERT_EQ(0, client_register(oid));
+  auto metadata = create_metadata(oid);
+  ASSERT_EQ(0, init_metadata(metadata));
+
+  ceph::mutex lock = ceph::make_mutex("object_recorder_lock");
+  ObjectRecorderFlusher flusher(m_ioctx, m_work_queue, 0, 0, 600, 0);
+  auto object = flusher.create_object(oid, 20, &lock);
+
+  // appends may still be in flight when the overflow is reported, so
+  // close the object before claiming its buffers like JournalRecorder
+  flusher.set_claim_on_overflow(false);
+
+  CompletionOrder completion_order;
+  std::vector<journal::AppendBuffer> appended;
+  size_t max_in_flight = append_until_pipelined(object.get(), &lock, "payload",
+                                                &completion_order, &appended);
+  ASSERT_LT(1U, max_in_flight);
+
+  // an entry that does not fit in the object overflows it while batches
+  // are still pipelined
+  auto append_buffer = create_tracked_append_buffer(
+    234, 123 + appended.size(), std::string(1 << 20, '1'), &completion_order);
+  appended.push_back(append_buffer);
+  journal::AppendBuffers append_buffers = {append_buffer};
+  lock.lock();
+  bool overflowed = object->append(std::move(append_buffers));
+  lock.unlock();
+
+  // the overflow is either detected upon append or once a pipelined
+  // append completes
+  if (!overflowed) {
+    ASSERT_TRUE(flusher.wait_for_overflow());
+  }
+
+  lock.lock();
+  bool closed = object->close();
+  lock.unlock();
+  if (!closed) {
+    ASSERT_TRUE(flusher.wait_for_closed());
+  }
+  ASSERT_EQ(0U, object->get_in_flight_appends());
+
+  journal::AppendBuffers claimed;
+  lock.lock();
+  object->claim_append_buffers(&claimed);
+  lock.unlock();
+
+  // every sent entry completed in order and the remaining entries were
+  // handed back in order for the next object
+  ASSERT_FALSE(claimed.empty());
+  size_t completed = appended.size() - claimed.size();
+  for (size_t i = 0; i < completed; ++i) {
+    C_SaferCond cond;
+    appended[i].first->wait(&cond);
+    ASSERT_EQ(0, cond.wait());
+  }
+  auto claimed_it = claimed.begin();
+  for (size_t i = completed; i < appended.size(); ++i, ++claimed_it) {
+    ASSERT_EQ(appended[i].first, claimed_it->first);
+    ASSERT_FALSE(appended[i].first->is_complete());
+  }
+
+  std::lock_guard locker{completion_order.lock};
+  ASSERT_EQ(completed, completion_order.entry_tids.size());
+  ASSERT_TRUE(std::is_sorted(completion_order.entry_tids.begin(),
+                             completion_order.entry_tids.end()));
+}
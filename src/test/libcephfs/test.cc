@@ -35,6 +35,7 @@
 #endif
 
 #include <fmt/format.h>
+#include <atomic>
 #include <map>
 #include <vector>
 #include <thread>
@@ -3576,3 +3577,127 @@ TEST(LibCephFS, SetMountTimeout) {
 
   ceph_shutdown(cmount);
 }
+
+TEST(LibCephFS, ParallelFileIO) {
+  struct ceph_mount_info *cmount;
+  ASSERT_EQ(ceph_create(&cmount, NULL), 0);
+  ASSERT_EQ(ceph_conf_read_file(cmount, NULL), 0);
+  ASSERT_EQ(0, ceph_conf_parse_env(cmount, NULL));
+  ASSERT_EQ(ceph_mount(cmount, NULL), 0);
+
+  char dir_path[64];
+  sprintf(dir_path, "/parallel_io_%d", getpid());
+  ASSERT_EQ(0, ceph_mkdir(cmount, dir_path, 0777));
+
+  const int num_threads = 8;
+  const int num_writes = 64;
+  const size_t io_size = 64 << 10;
+
+  std::atomic<int> failures{0};
+  auto worker = [&](int id) {
+    char file_path[128];
+    sprintf(file_path, "%s/file_%d", dir_path, id);
+    int fd = ceph_open(cmount, file_path, O_RDWR|O_CREAT|O_TRUNC, 0666);
+    if (fd < 0) {
+      ++failures;
+      return;
+    }
+
+    std::string out(io_size, 'a' + id);
+    for (int i = 0; i < num_writes; ++i) {
+      if (ceph_write(cmount, fd, out.data(), io_size, i * io_size) !=
+            (int)io_size) {
+        ++failures;
+      }
+    }
+    if (ceph_fsync(cmount, fd, 0) < 0) {
+      ++failures;
+    }
+
+    std::string in(io_size, '\0');
+    for (int i = 0; i < num_writes; ++i) {
+      if (ceph_read(cmount, fd, in.data(), io_size, i * io_size) !=
+            (int)io_size || in != out) {
+        ++failures;
+      }
+    }
+    ceph_close(cmount, fd);
+    ceph_unlink(cmount, file_path);
+  };
+
+  utime_t start = ceph_clock_now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back(worker, i);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  utime_t elapsed = ceph_clock_now() - start;
+  ASSERT_EQ(0, failures);
+
+  double mb = 2.0 * num_threads * num_writes * io_size / (1 << 20);
+  std::cout << num_threads << " threads moved " << mb << " MiB in "
+            << elapsed << "s (" << mb / (double)elapsed << " MiB/s)"
+            << std::endl;
+
+  // concurrent appends to one file, through per-thread O_APPEND fds and
+  // through one shared fd, must each land in a block of their own
+  const size_t block_size = 4 << 10;
+  char shared_path[128];
+  sprintf(shared_path, "%s/shared", dir_path);
+  for (bool shared_fd : {false, true}) {
+    int sfd = ceph_open(cmount, shared_path, O_RDWR|O_CREAT|O_TRUNC, 0666);
+    ASSERT_LE(0, sfd);
+
+    auto appender = [&](int id) {
+      int fd = shared_fd ? sfd :
+        ceph_open(cmount, shared_path, O_WRONLY|O_APPEND, 0666);
+      if (fd < 0) {
+        ++failures;
+        return;
+      }
+      std::string out(block_size, 'a' + id);
+      for (int i = 0; i < num_writes; ++i) {
+        if (ceph_write(cmount, fd, out.data(), block_size, -1) !=
+              (int)block_size) {
+          ++failures;
+        }
+      }
+      if (!shared_fd) {
+        ceph_close(cmount, fd);
+      }
+    };
+
+    threads.clear();
+    for (int i = 0; i < num_threads; ++i) {
+      threads.emplace_back(appender, i);
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    ASSERT_EQ(0, failures);
+
+    struct ceph_statx stx;
+    ASSERT_EQ(0, ceph_fstatx(cmount, sfd, &stx, CEPH_STATX_SIZE, 0));
+    ASSERT_EQ(num_threads * num_writes * block_size, stx.stx_size);
+
+    std::map<char, int> blocks;
+    std::string in(block_size, '\0');
+    for (int i = 0; i < num_threads * num_writes; ++i) {
+      ASSERT_EQ((int)block_size,
+                ceph_read(cmount, sfd, in.data(), block_size, i * block_size));
+      ASSERT_EQ(std::string(block_size, in[0]), in);
+      ++blocks[in[0]];
+    }
+    ASSERT_EQ((size_t)num_threads, blocks.size());
+    for (auto& [c, n] : blocks) {
+      ASSERT_EQ(num_writes, n);
+    }
+    ceph_close(cmount, sfd);
+  }
+  ASSERT_EQ(0, ceph_unlink(cmount, shared_path));
+
+  ASSERT_EQ(0, ceph_rmdir(cmount, dir_path));
+  ceph_shutdown(cmount);
+}
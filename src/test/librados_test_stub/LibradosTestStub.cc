@@ -930,6 +930,17 @@ void ObjectWriteOperation::append(const bufferlist &bl) {
   o->ops.push_back(std::bind(&TestIoCtxImpl::append, _1, _2, bl, _5));
 }
 
+void ObjectWriteOperation::copy_from(const std::string& src,
+                                     const IoCtx& src_ioctx,
+                                     uint64_t src_version,
+                                     uint32_t src_fadvise_flags) {
+  TestObjectOperationImpl *o = reinterpret_cast<TestObjectOperationImpl*>(impl);
+  TestIoCtxImpl *src_ctx = reinterpret_cast<TestIoCtxImpl*>(
+    src_ioctx.io_ctx_impl);
+  o->ops.push_back(std::bind(&TestIoCtxImpl::copy_from, _1, _2, src_ctx, src,
+                             src_ctx->get_snap_read(), _5));
+}
+
 void ObjectWriteOperation::create(bool exclusive) {
   TestObjectOperationImpl *o = reinterpret_cast<TestObjectOperationImpl*>(impl);
   o->ops.push_back(std::bind(&TestIoCtxImpl::create, _1, _2, exclusive, _5));
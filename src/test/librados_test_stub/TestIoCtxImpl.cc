@@ -268,6 +268,22 @@ int TestIoCtxImpl::set_alloc_hint(const std::string& oid,
   return 0;
 }
 
+int TestIoCtxImpl::copy_from(const std::string& oid,
+                             TestIoCtxImpl *src_io_ctx,
+                             const std::string& src_oid, uint64_t src_snap_id,
+                             const SnapContext &snapc) {
+  if (m_client->is_blocklisted()) {
+    return -EBLOCKLISTED;
+  }
+
+  bufferlist bl;
+  int r = src_io_ctx->read(src_oid, 0, 0, &bl, src_snap_id, nullptr);
+  if (r < 0) {
+    return r;
+  }
+  return write_full(oid, bl, snapc);
+}
+
 void TestIoCtxImpl::set_snap_read(snap_t seq) {
   if (seq == 0) {
     seq = CEPH_NOSNAP;
@@ -103,6 +103,9 @@ public:
   virtual int assert_exists(const std::string &oid, uint64_t snap_id) = 0;
   virtual int assert_version(const std::string &oid, uint64_t ver) = 0;
 
+  virtual int copy_from(const std::string& oid, TestIoCtxImpl *src_io_ctx,
+                        const std::string& src_oid, uint64_t src_snap_id,
+                        const SnapContext &snapc);
   virtual int create(const std::string& oid, bool exclusive,
                      const SnapContext &snapc) = 0;
   virtual int exec(const std::string& oid, TestClassHandler *handler,
@@ -40,6 +40,11 @@ struct TestLogEntry {
   void dec_map_ref() {
     referring_map_entries--;
   }
+  void occluded_by(const std::shared_ptr<TestLogEntry> &entry) {
+  }
+  bool occluders_persisted() {
+    return true;
+  }
   friend std::ostream &operator<<(std::ostream &os,
                                   const TestLogEntry &entry) {
     os << "referring_map_entries=" << entry.referring_map_entries << ", "
@@ -53,6 +58,19 @@ typedef std::list<std::shared_ptr<TestLogEntry>> TestLogEntries;
 typedef LogMapEntry<TestLogEntry> TestMapEntry;
 typedef LogMapEntries<TestLogEntry> TestLogMapEntries;
 typedef LogMap<TestLogEntry> TestLogMap;
+typedef LogMap<GenericWriteLogEntry> WriteLogMap;
+
+/* Real write log entries, to exercise the occlusion tracking */
+std::shared_ptr<GenericWriteLogEntry> make_write_entry(
+    uint64_t image_offset_bytes, uint64_t write_bytes,
+    uint64_t sync_gen_number, bool persisted) {
+  auto entry = make_shared<DiscardLogEntry>(image_offset_bytes, write_bytes);
+  entry->ram_entry.sync_gen_number = sync_gen_number;
+  if (persisted) {
+    entry->set_persisted();
+  }
+  return entry;
+}
 
 class TestWriteLogMap : public TestFixture {
 public:
@@ -333,6 +351,84 @@ TEST_F(TestWriteLogMap, OverlapSplit) {
   ASSERT_EQ(8, found0.front().block_extent.block_end);
 }
 
+TEST_F(TestWriteLogMap, OccludedByPersisted) {
+  WriteLogMap map(m_cct);
+
+  auto e0 = make_write_entry(0, 8, 1, true);
+  map.add_log_entry(e0);
+  ASSERT_FALSE(map.is_occluded(e0));
+
+  auto e1 = make_write_entry(0, 8, 1, true);
+  map.add_log_entry(e1);
+  ASSERT_TRUE(map.is_occluded(e0));
+  ASSERT_TRUE(e0->occluded_within_sync_gen());
+  ASSERT_FALSE(map.is_occluded(e1));
+}
+
+TEST_F(TestWriteLogMap, OccludedByUnpersisted) {
+  WriteLogMap map(m_cct);
+
+  auto e0 = make_write_entry(0, 8, 1, true);
+  map.add_log_entry(e0);
+
+  /* e1 replaces all of e0 in the map, but isn't in the log yet */
+  auto e1 = make_write_entry(0, 8, 1, false);
+  map.add_log_entry(e1);
+  ASSERT_EQ(0, e0->get_map_ref());
+  ASSERT_FALSE(map.is_occluded(e0));
+
+  e1->set_persisted();
+  ASSERT_TRUE(map.is_occluded(e0));
+}
+
+TEST_F(TestWriteLogMap, OccludedByFailedWrite) {
+  WriteLogMap map(m_cct);
+
+  auto e0 = make_write_entry(0, 8, 1, true);
+  map.add_log_entry(e0);
+
+  /* e1 never persists (its append failed), so e0 must be written back */
+  auto e1 = make_write_entry(0, 8, 1, false);
+  map.add_log_entry(e1);
+  e1->completed = true;
+  ASSERT_FALSE(map.is_occluded(e0));
+}
+
+TEST_F(TestWriteLogMap, OccludedPartially) {
+  WriteLogMap map(m_cct);
+
+  auto e0 = make_write_entry(0, 8, 1, true);
+  map.add_log_entry(e0);
+
+  auto e1 = make_write_entry(0, 4, 1, true);
+  map.add_log_entry(e1);
+  ASSERT_FALSE(map.is_occluded(e0));
+
+  auto e2 = make_write_entry(4, 4, 1, false);
+  map.add_log_entry(e2);
+  ASSERT_FALSE(map.is_occluded(e0));
+
+  e2->set_persisted();
+  ASSERT_TRUE(map.is_occluded(e0));
+  ASSERT_TRUE(e0->occluded_within_sync_gen());
+}
+
+TEST_F(TestWriteLogMap, OccludedInLaterSyncGen) {
+  WriteLogMap map(m_cct);
+
+  auto e0 = make_write_entry(0, 8, 1, true);
+  map.add_log_entry(e0);
+
+  auto e1 = make_write_entry(0, 4, 1, true);
+  map.add_log_entry(e1);
+  auto e2 = make_write_entry(4, 4, 2, true);
+  map.add_log_entry(e2);
+
+  /* Replaced, but not entirely by writes from its own sync gen */
+  ASSERT_TRUE(map.is_occluded(e0));
+  ASSERT_FALSE(e0->occluded_within_sync_gen());
+}
+
 } // namespace pwl
 } // namespace cache
 } // namespace librbd
@@ -759,6 +759,86 @@ TEST_F(TestMockCacheReplicatedWriteLog, compare_and_write_compare_failed) {
   ASSERT_EQ(0, finish_ctx3.wait());
 }
 
+TEST_F(TestMockCacheReplicatedWriteLog, can_skip_writeback) {
+  /* Exposes the writeback skip decision for entries placed straight into
+   * the log map */
+  struct TestReplicatedWriteLog : public MockReplicatedWriteLog {
+    using MockReplicatedWriteLog::MockReplicatedWriteLog;
+
+    void add_log_entry(std::shared_ptr<GenericWriteLogEntry> log_entry) {
+      this->m_blocks_to_log_entries.add_log_entry(log_entry);
+    }
+    bool can_skip_writeback(std::shared_ptr<GenericLogEntry> log_entry) {
+      std::lock_guard locker(this->m_lock);
+      return MockReplicatedWriteLog::can_skip_writeback(log_entry);
+    }
+  };
+  auto make_entry = [](uint64_t image_offset_bytes, uint64_t write_bytes,
+                       uint64_t sync_gen_number) {
+    auto entry = std::make_shared<rwl::WriteLogEntry>(image_offset_bytes,
+                                                      write_bytes);
+    entry->ram_entry.sync_gen_number = sync_gen_number;
+    return entry;
+  };
+
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockImageCtx mock_image_ctx(*ictx);
+  MockImageWriteback mock_image_writeback(mock_image_ctx);
+  MockApi mock_api;
+  TestReplicatedWriteLog rwl(
+      mock_image_ctx, get_cache_state(mock_image_ctx, mock_api),
+      mock_image_writeback, mock_api);
+
+  expect_op_work_queue(mock_image_ctx);
+  expect_metadata_set(mock_image_ctx);
+
+  MockContextRWL finish_ctx1;
+  expect_context_complete(finish_ctx1, 0);
+  rwl.init(&finish_ctx1);
+  ASSERT_EQ(0, finish_ctx1.wait());
+
+  auto e0 = make_entry(0, 4096, 1);
+  e0->set_persisted();
+  rwl.add_log_entry(e0);
+  ASSERT_FALSE(rwl.can_skip_writeback(e0));
+
+  /* Overwritten by a write that isn't persisted yet */
+  auto e1 = make_entry(0, 4096, 1);
+  rwl.add_log_entry(e1);
+  ASSERT_FALSE(rwl.can_skip_writeback(e0));
+
+  e1->set_persisted();
+  ASSERT_TRUE(rwl.can_skip_writeback(e0));
+  ASSERT_FALSE(rwl.can_skip_writeback(e1));
+
+  /* Overwritten in a later sync gen: the image must see the older data
+   * at the sync point in between */
+  auto e2 = make_entry(4096, 4096, 1);
+  e2->set_persisted();
+  rwl.add_log_entry(e2);
+  auto e3 = make_entry(4096, 4096, 2);
+  e3->set_persisted();
+  rwl.add_log_entry(e3);
+  ASSERT_FALSE(rwl.can_skip_writeback(e2));
+
+  /* Only writes are skipped */
+  auto e4 = std::make_shared<DiscardLogEntry>(8192, 4096);
+  e4->ram_entry.sync_gen_number = 1;
+  e4->set_persisted();
+  rwl.add_log_entry(e4);
+  auto e5 = make_entry(8192, 4096, 1);
+  e5->set_persisted();
+  rwl.add_log_entry(e5);
+  ASSERT_FALSE(rwl.can_skip_writeback(e4));
+
+  MockContextRWL finish_ctx2;
+  expect_context_complete(finish_ctx2, 0);
+  rwl.shut_down(&finish_ctx2);
+  ASSERT_EQ(0, finish_ctx2.wait());
+}
+
 } // namespace pwl
 } // namespace cache
 } // namespace librbd
@@ -7,6 +7,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "include/Context.h"
+#include "include/stringify.h"
 #include "tools/immutable_object_cache/CacheClient.h"
 #include "test/immutable_object_cache/MockCacheDaemon.h"
 #include "librbd/cache/ParentCacheObjectDispatch.h"
@@ -424,4 +425,63 @@ TEST_F(TestMockParentCacheObjectDispatch, test_read_dne) {
   delete mock_parent_image_cache;
 }
 
+TEST_F(TestMockParentCacheObjectDispatch, test_read_mapped) {
+  librbd::ImageCtx* ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+  MockParentImageCacheImageCtx mock_image_ctx(*ictx);
+  mock_image_ctx.child = &mock_image_ctx;
+
+  std::string cache_path = "/tmp/test_mock_parent_cache_object_" +
+                           stringify(getpid());
+  bufferlist cache_bl;
+  cache_bl.append(std::string(8192, '1'));
+  cache_bl.append(std::string(4096, '2'));
+  ASSERT_EQ(0, cache_bl.write_file(cache_path.c_str()));
+
+  MockPluginApi mock_plugin_api;
+  auto mock_parent_image_cache = MockParentImageCache::create(&mock_image_ctx,
+                                                              mock_plugin_api);
+
+  expect_cache_run(*mock_parent_image_cache, 0);
+  C_SaferCond conn_cond;
+  Context* handle_connect = new LambdaContext([&conn_cond](int ret) {
+    ASSERT_EQ(ret, 0);
+    conn_cond.complete(0);
+  });
+  expect_cache_async_connect(*mock_parent_image_cache, 0, handle_connect);
+  Context* ctx = new LambdaContext([](bool reg) {
+    ASSERT_EQ(reg, true);
+  });
+  expect_cache_register(*mock_parent_image_cache, ctx, 0);
+  expect_io_object_dispatcher_register_state(*mock_parent_image_cache, 0);
+  expect_cache_close(*mock_parent_image_cache, 0);
+  expect_cache_stop(*mock_parent_image_cache, 0);
+
+  mock_parent_image_cache->init();
+  conn_cond.wait();
+
+  EXPECT_CALL(*(mock_parent_image_cache->get_cache_client()), is_session_work())
+    .WillOnce(Return(true));
+
+  expect_cache_lookup_object(*mock_parent_image_cache, cache_path);
+
+  C_SaferCond on_dispatched;
+  io::DispatchResult dispatch_result;
+  io::ReadExtents extents = {{4096, 4096}, {8192, 8192}};
+  mock_parent_image_cache->read(
+    0, &extents, mock_image_ctx.get_data_io_context(), 0, 0, {}, nullptr,
+    nullptr, &dispatch_result, nullptr, &on_dispatched);
+  ASSERT_EQ(8192, on_dispatched.wait());
+  ASSERT_EQ(io::DISPATCH_RESULT_COMPLETE, dispatch_result);
+
+  // the mapping outlives the cache file being evicted
+  ::unlink(cache_path.c_str());
+  ASSERT_EQ(std::string(4096, '1'), extents[0].bl.to_str());
+  ASSERT_EQ(std::string(4096, '2'), extents[1].bl.to_str());
+
+  mock_parent_image_cache->get_cache_client()->close();
+  mock_parent_image_cache->get_cache_client()->stop();
+  delete mock_parent_image_cache;
+}
+
 }  // namespace librbd
@@ -5,7 +5,6 @@
 #include "librbd/crypto/CryptoContextPool.h"
 #include "test/librbd/mock/crypto/MockDataCryptor.h"
 
-#include "librbd/crypto/CryptoContextPool.cc"
 template class librbd::crypto::CryptoContextPool<
         librbd::crypto::MockCryptoContext>;
 
@@ -15,21 +14,22 @@ namespace librbd {
 namespace crypto {
 
 struct TestMockCryptoCryptoContextPool : public ::testing::Test {
-    MockDataCryptor cryptor;
+    // owned by the pool under test
+    MockDataCryptor* cryptor = new MockDataCryptor();
 
     void expect_get_context(CipherMode mode) {
-      EXPECT_CALL(cryptor, get_context(mode)).WillOnce(Return(
+      EXPECT_CALL(*cryptor, get_context(mode)).WillOnce(Return(
               new MockCryptoContext()));
     }
 
     void expect_return_context(MockCryptoContext* ctx, CipherMode mode) {
       delete ctx;
-      EXPECT_CALL(cryptor, return_context(ctx, mode));
+      EXPECT_CALL(*cryptor, return_context(ctx, mode));
     }
 };
 
 TEST_F(TestMockCryptoCryptoContextPool, Test) {
-  CryptoContextPool<MockCryptoContext> pool(&cryptor, 1);
+  CryptoContextPool<MockCryptoContext> pool(cryptor, 1);
 
   expect_get_context(CipherMode::CIPHER_MODE_ENC);
   auto enc_ctx = pool.get_context(CipherMode::CIPHER_MODE_ENC);
@@ -588,8 +588,106 @@ TEST_F(TestMockImageRefreshRequest, SuccessV2) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, -EOPNOTSUPP);
+  expect_apply_metadata(mock_image_ctx, 0);
+  expect_refresh_parent_is_required(mock_refresh_parent_request, false);
+  if (ictx->test_features(RBD_FEATURE_EXCLUSIVE_LOCK)) {
+    expect_init_exclusive_lock(mock_image_ctx, mock_exclusive_lock, 0);
+  }
+  EXPECT_CALL(mock_image_ctx, rebuild_data_io_context());
+
+  C_SaferCond ctx;
+  MockRefreshRequest *req = new MockRefreshRequest(mock_image_ctx, false, false, &ctx);
+  req->send();
+
+  ASSERT_EQ(0, ctx.wait());
+}
+
+TEST_F(TestMockImageRefreshRequest, SuccessImageMetadataOverridesPool) {
+  REQUIRE_FORMAT_V2();
+
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockRefreshImageCtx mock_image_ctx(*ictx);
+  MockRefreshParentRequest mock_refresh_parent_request;
+  MockExclusiveLock mock_exclusive_lock;
+  expect_op_work_queue(mock_image_ctx);
+  expect_test_features(mock_image_ctx);
+
+  bufferlist image_bl;
+  image_bl.append("image");
+  bufferlist pool_bl;
+  pool_bl.append("pool");
+  Metadata image_metadata{{"conf_rbd_cache", image_bl}};
+  Metadata pool_metadata{{"conf_rbd_cache", pool_bl},
+                         {"conf_rbd_cache_size", pool_bl}};
+  Metadata expected_metadata{{"conf_rbd_cache", image_bl},
+                             {"conf_rbd_cache_size", pool_bl}};
+
+  InSequence seq;
+  expect_get_mutable_metadata(mock_image_ctx, ictx->features, 0);
+  expect_get_parent(mock_image_ctx, 0);
+  MockGetMetadataRequest mock_get_metadata_request;
+  expect_get_metadata(mock_image_ctx, mock_get_metadata_request,
+                      mock_image_ctx.header_oid, image_metadata, 0);
+  expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO,
+                      pool_metadata, 0);
+  expect_get_group(mock_image_ctx, 0);
+  EXPECT_CALL(*mock_image_ctx.image_watcher, is_unregistered())
+    .WillOnce(Return(false));
+  EXPECT_CALL(mock_image_ctx, apply_metadata(expected_metadata, false))
+    .WillOnce(Return(0));
+  expect_refresh_parent_is_required(mock_refresh_parent_request, false);
+  if (ictx->test_features(RBD_FEATURE_EXCLUSIVE_LOCK)) {
+    expect_init_exclusive_lock(mock_image_ctx, mock_exclusive_lock, 0);
+  }
+  EXPECT_CALL(mock_image_ctx, rebuild_data_io_context());
+
+  C_SaferCond ctx;
+  MockRefreshRequest *req = new MockRefreshRequest(mock_image_ctx, false, false, &ctx);
+  req->send();
+
+  ASSERT_EQ(0, ctx.wait());
+}
+
+TEST_F(TestMockImageRefreshRequest, SuccessSharedQosIgnoresImageMetadata) {
+  REQUIRE_FORMAT_V2();
+
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockRefreshImageCtx mock_image_ctx(*ictx);
+  MockRefreshParentRequest mock_refresh_parent_request;
+  MockExclusiveLock mock_exclusive_lock;
+  expect_op_work_queue(mock_image_ctx);
+  expect_test_features(mock_image_ctx);
+
+  bufferlist image_bl;
+  image_bl.append("100");
+  bufferlist pool_bl;
+  pool_bl.append("50");
+  Metadata image_metadata{{"conf_rbd_qos_iops_limit", image_bl},
+                          {"conf_rbd_qos_namespace_iops_limit", image_bl},
+                          {"conf_rbd_qos_pool_iops_limit", image_bl}};
+  Metadata pool_metadata{{"conf_rbd_qos_iops_limit", pool_bl},
+                         {"conf_rbd_qos_pool_iops_limit", pool_bl}};
+  Metadata expected_metadata{{"conf_rbd_qos_iops_limit", image_bl},
+                             {"conf_rbd_qos_pool_iops_limit", pool_bl}};
+
+  InSequence seq;
+  expect_get_mutable_metadata(mock_image_ctx, ictx->features, 0);
+  expect_get_parent(mock_image_ctx, 0);
+  MockGetMetadataRequest mock_get_metadata_request;
+  expect_get_metadata(mock_image_ctx, mock_get_metadata_request,
+                      mock_image_ctx.header_oid, image_metadata, 0);
+  expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO,
+                      pool_metadata, 0);
+  expect_get_group(mock_image_ctx, 0);
+  EXPECT_CALL(*mock_image_ctx.image_watcher, is_unregistered())
+    .WillOnce(Return(false));
+  EXPECT_CALL(mock_image_ctx, apply_metadata(expected_metadata, false))
+    .WillOnce(Return(0));
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   if (ictx->test_features(RBD_FEATURE_EXCLUSIVE_LOCK)) {
     expect_init_exclusive_lock(mock_image_ctx, mock_exclusive_lock, 0);
@@ -624,8 +722,8 @@ TEST_F(TestMockImageRefreshRequest, SuccessSnapshotV2) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_snapshots(mock_image_ctx, false, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   if (ictx->test_features(RBD_FEATURE_EXCLUSIVE_LOCK)) {
@@ -663,8 +761,8 @@ TEST_F(TestMockImageRefreshRequest, SuccessLegacySnapshotV2) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_snapshots(mock_image_ctx, true, -EOPNOTSUPP);
   expect_get_snapshots_legacy(mock_image_ctx, true, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
@@ -703,8 +801,8 @@ TEST_F(TestMockImageRefreshRequest, SuccessLegacySnapshotNoTimestampV2) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_snapshots(mock_image_ctx, true, -EOPNOTSUPP);
   expect_get_snapshots_legacy(mock_image_ctx, true, -EOPNOTSUPP);
   expect_get_snapshots_legacy(mock_image_ctx, false, 0);
@@ -747,8 +845,8 @@ TEST_F(TestMockImageRefreshRequest, SuccessSetSnapshotV2) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_snapshots(mock_image_ctx, false, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   if (ictx->test_features(RBD_FEATURE_OBJECT_MAP)) {
@@ -805,9 +903,9 @@ TEST_F(TestMockImageRefreshRequest, SuccessChild) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_op_features(mock_image_ctx, RBD_OPERATION_FEATURE_CLONE_CHILD, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_refresh_parent_is_required(*mock_refresh_parent_request, true);
   expect_refresh_parent_send(mock_image_ctx, *mock_refresh_parent_request, 0);
   if (ictx->test_features(RBD_FEATURE_EXCLUSIVE_LOCK)) {
@@ -863,9 +961,9 @@ TEST_F(TestMockImageRefreshRequest, SuccessChildDontOpenParent) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_op_features(mock_image_ctx, RBD_OPERATION_FEATURE_CLONE_CHILD, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   if (ictx->test_features(RBD_FEATURE_EXCLUSIVE_LOCK)) {
     expect_init_exclusive_lock(mock_image_ctx, mock_exclusive_lock, 0);
   }
@@ -900,9 +998,9 @@ TEST_F(TestMockImageRefreshRequest, SuccessOpFeatures) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_op_features(mock_image_ctx, 4096, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   if (ictx->test_features(RBD_FEATURE_EXCLUSIVE_LOCK)) {
     expect_init_exclusive_lock(mock_image_ctx, mock_exclusive_lock, 0);
@@ -970,8 +1068,8 @@ TEST_F(TestMockImageRefreshRequest, DisableExclusiveLock) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   EXPECT_CALL(mock_image_ctx, rebuild_data_io_context());
   expect_shut_down_exclusive_lock(mock_image_ctx, mock_exclusive_lock, 0);
@@ -1025,8 +1123,8 @@ TEST_F(TestMockImageRefreshRequest, DisableExclusiveLockWhileAcquiringLock) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   EXPECT_CALL(mock_image_ctx, rebuild_data_io_context());
 
@@ -1070,8 +1168,8 @@ TEST_F(TestMockImageRefreshRequest, JournalDisabledByPolicy) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
 
   MockJournalPolicy mock_journal_policy;
@@ -1120,8 +1218,8 @@ TEST_F(TestMockImageRefreshRequest, EnableJournalWithExclusiveLock) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
 
   MockJournalPolicy mock_journal_policy;
@@ -1169,8 +1267,8 @@ TEST_F(TestMockImageRefreshRequest, EnableJournalWithoutExclusiveLock) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   expect_set_require_lock(mock_exclusive_lock, librbd::io::DIRECTION_BOTH);
   EXPECT_CALL(mock_image_ctx, rebuild_data_io_context());
@@ -1221,8 +1319,8 @@ TEST_F(TestMockImageRefreshRequest, DisableJournal) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   expect_block_writes(mock_image_ctx, 0);
   EXPECT_CALL(mock_image_ctx, rebuild_data_io_context());
@@ -1274,8 +1372,8 @@ TEST_F(TestMockImageRefreshRequest, EnableObjectMapWithExclusiveLock) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   expect_open_object_map(mock_image_ctx, &mock_object_map, 0);
   EXPECT_CALL(mock_image_ctx, rebuild_data_io_context());
@@ -1319,8 +1417,8 @@ TEST_F(TestMockImageRefreshRequest, EnableObjectMapWithoutExclusiveLock) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   EXPECT_CALL(mock_image_ctx, rebuild_data_io_context());
 
@@ -1370,8 +1468,8 @@ TEST_F(TestMockImageRefreshRequest, DisableObjectMap) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   EXPECT_CALL(mock_image_ctx, rebuild_data_io_context());
   expect_close_object_map(mock_image_ctx, mock_object_map, 0);
@@ -1417,8 +1515,8 @@ TEST_F(TestMockImageRefreshRequest, OpenObjectMapError) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   expect_open_object_map(mock_image_ctx, &mock_object_map, -EBLOCKLISTED);
   EXPECT_CALL(mock_image_ctx, rebuild_data_io_context());
@@ -1466,8 +1564,8 @@ TEST_F(TestMockImageRefreshRequest, OpenObjectMapTooLarge) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   expect_open_object_map(mock_image_ctx, &mock_object_map, -EFBIG);
   EXPECT_CALL(mock_image_ctx, rebuild_data_io_context());
@@ -1501,8 +1599,8 @@ TEST_F(TestMockImageRefreshRequest, ApplyMetadataError) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, -EINVAL);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, -EINVAL);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   if (ictx->test_features(RBD_FEATURE_EXCLUSIVE_LOCK)) {
     expect_init_exclusive_lock(mock_image_ctx, mock_exclusive_lock, 0);
@@ -1539,8 +1637,8 @@ TEST_F(TestMockImageRefreshRequest, NonPrimaryFeature) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   EXPECT_CALL(mock_image_ctx, rebuild_data_io_context());
 
@@ -1562,8 +1660,8 @@ TEST_F(TestMockImageRefreshRequest, NonPrimaryFeature) {
                       mock_image_ctx.header_oid, {}, 0);
   expect_get_metadata(mock_image_ctx, mock_get_metadata_request, RBD_INFO, {},
                       0);
-  expect_apply_metadata(mock_image_ctx, 0);
   expect_get_group(mock_image_ctx, 0);
+  expect_apply_metadata(mock_image_ctx, 0);
   expect_refresh_parent_is_required(mock_refresh_parent_request, false);
   if (ictx->test_features(RBD_FEATURE_EXCLUSIVE_LOCK)) {
     expect_init_exclusive_lock(mock_image_ctx, mock_exclusive_lock, 0);
@@ -200,15 +200,21 @@ struct TestMockIoCopyupRequest : public TestMockFixture {
 
   void expect_read_parent(librbd::MockTestImageCtx& mock_image_ctx,
                           const Extents& image_extents,
-                          const std::string& data, int r) {
+                          const std::string& data, int r,
+                          const std::function<void()>& on_read = {}) {
     EXPECT_CALL(*mock_image_ctx.io_image_dispatcher,
                 send(IsRead(image_extents)))
       .WillOnce(Invoke(
-        [&mock_image_ctx, image_extents, data, r](io::ImageDispatchSpec* spec) {
+        [&mock_image_ctx, image_extents, data, r, on_read]
+        (io::ImageDispatchSpec* spec) {
           auto req = boost::get<librbd::io::ImageDispatchSpec::Read>(
             &spec->request);
           ASSERT_TRUE(req != nullptr);
 
+          if (on_read) {
+            on_read();
+          }
+
           if (r < 0) {
             spec->fail(r);
             return;
@@ -1231,11 +1237,12 @@ TEST_F(TestMockIoCopyupRequest, ProcessCopyup) {
 
   InSequence seq;
 
-  std::string data(4096, '1');
-  expect_read_parent(mock_parent_image_ctx, {{0, 4096}}, data, 0);
+  // parent data overwritten by the write-op is not read
+  std::string data(3072, '1');
+  expect_read_parent(mock_parent_image_ctx, {{1024, 3072}}, data, 0);
 
   bufferlist in_prepare_bl;
-  in_prepare_bl.append(std::string(3072, '1'));
+  in_prepare_bl.append(data);
   bufferlist out_prepare_bl;
   out_prepare_bl.substr_of(in_prepare_bl, 0, 1024);
   expect_prepare_copyup(
@@ -1330,5 +1337,205 @@ TEST_F(TestMockIoCopyupRequest, ProcessCopyupOverwrite) {
   ASSERT_EQ(0, mock_write_request.ctx.wait());
 }
 
+TEST_F(TestMockIoCopyupRequest, ProcessCopyupFullyOverwritten) {
+  REQUIRE_FEATURE(RBD_FEATURE_LAYERING);
+
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockTestImageCtx mock_parent_image_ctx(*ictx->parent);
+  MockTestImageCtx mock_image_ctx(*ictx, &mock_parent_image_ctx);
+
+  MockExclusiveLock mock_exclusive_lock;
+  MockJournal mock_journal;
+  MockObjectMap mock_object_map;
+  initialize_features(ictx, mock_image_ctx, mock_exclusive_lock, mock_journal,
+                      mock_object_map);
+
+  expect_op_work_queue(mock_image_ctx);
+  expect_is_lock_owner(mock_image_ctx);
+
+  // the write-op covers the whole parent overlap: nothing to read
+  EXPECT_CALL(*mock_parent_image_ctx.io_image_dispatcher, send(_)).Times(0);
+
+  InSequence seq;
+
+  expect_prepare_copyup(mock_image_ctx, {}, {});
+
+  MockAbstractObjectWriteRequest mock_write_request;
+  expect_is_empty_write_op(mock_write_request, false);
+  expect_get_pre_write_object_map_state(mock_image_ctx, mock_write_request,
+                                        OBJECT_EXISTS);
+  expect_object_map_at(mock_image_ctx, 0, OBJECT_NONEXISTENT);
+  expect_object_map_update(mock_image_ctx, CEPH_NOSNAP, 0, OBJECT_EXISTS, true,
+                           0);
+
+  expect_add_copyup_ops(mock_write_request);
+  expect_sparse_copyup(mock_image_ctx, CEPH_NOSNAP, ictx->get_object_name(0),
+                       {}, "", 0);
+  expect_write(mock_image_ctx, CEPH_NOSNAP, ictx->get_object_name(0), 0);
+
+  auto req = new MockCopyupRequest(&mock_image_ctx, 0,
+                                   {{0, 4096}}, {});
+  mock_image_ctx.copyup_list[0] = req;
+  req->append_request(&mock_write_request, {{0, 4096}});
+  req->send();
+
+  ASSERT_EQ(0, mock_write_request.ctx.wait());
+}
+
+TEST_F(TestMockIoCopyupRequest, ProcessCopyupSnapshotAfterPrune) {
+  REQUIRE_FEATURE(RBD_FEATURE_LAYERING);
+
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+  ictx->image_lock.lock();
+  ictx->add_snap(cls::rbd::UserSnapshotNamespace(), "1", 1, ictx->size,
+                 ictx->parent_md, RBD_PROTECTION_STATUS_UNPROTECTED,
+                 0, {});
+  ictx->snapc = {1, {1}};
+  ictx->image_lock.unlock();
+
+  MockTestImageCtx mock_parent_image_ctx(*ictx->parent);
+  MockTestImageCtx mock_image_ctx(*ictx, &mock_parent_image_ctx);
+
+  MockExclusiveLock mock_exclusive_lock;
+  MockJournal mock_journal;
+  MockObjectMap mock_object_map;
+  initialize_features(ictx, mock_image_ctx, mock_exclusive_lock, mock_journal,
+                      mock_object_map);
+
+  expect_test_features(mock_image_ctx);
+  expect_op_work_queue(mock_image_ctx);
+  expect_is_lock_owner(mock_image_ctx);
+
+  // the snapshot is created while the pruned parent read is in flight
+  auto snapc = mock_image_ctx.snapc;
+  auto snaps = mock_image_ctx.snaps;
+  mock_image_ctx.snapc = {};
+  mock_image_ctx.snaps.clear();
+
+  InSequence seq;
+
+  std::string data(4096, '1');
+  expect_read_parent(mock_parent_image_ctx, {{1024, 3072}},
+                     data.substr(1024), 0,
+                     [&mock_image_ctx, snapc, snaps]() {
+                       mock_image_ctx.snapc = snapc;
+                       mock_image_ctx.snaps = snaps;
+                     });
+
+  // the partial parent data cannot be copied up to the snapshot
+  MockAbstractObjectWriteRequest mock_write_request1;
+  auto req = new MockCopyupRequest(&mock_image_ctx, 0,
+                                   {{0, 4096}}, {});
+  mock_image_ctx.copyup_list[0] = req;
+  req->append_request(&mock_write_request1, {{0, 1024}});
+  req->send();
+
+  ASSERT_EQ(-ERESTART, mock_write_request1.ctx.wait());
+
+  // the restarted write-op triggers a copy-up that reads the full overlap
+  expect_read_parent(mock_parent_image_ctx, {{0, 4096}}, data, 0);
+
+  bufferlist in_prepare_bl;
+  in_prepare_bl.append(data);
+  expect_prepare_copyup(
+    mock_image_ctx,
+    {{0, {4096, {SPARSE_EXTENT_STATE_DATA, 4096, bufferlist{in_prepare_bl}}}}},
+    {{0, {4096, {SPARSE_EXTENT_STATE_DATA, 4096, bufferlist{in_prepare_bl}}}}});
+
+  MockAbstractObjectWriteRequest mock_write_request2;
+  expect_get_pre_write_object_map_state(mock_image_ctx, mock_write_request2,
+                                        OBJECT_EXISTS);
+  expect_object_map_at(mock_image_ctx, 0, OBJECT_NONEXISTENT);
+  expect_object_map_update(mock_image_ctx, 1, 0, OBJECT_EXISTS, true, 0);
+  expect_object_map_update(mock_image_ctx, CEPH_NOSNAP, 0, OBJECT_EXISTS, true,
+                           0);
+
+  expect_add_copyup_ops(mock_write_request2);
+  expect_sparse_copyup(mock_image_ctx, 0, ictx->get_object_name(0),
+                       {{0, 4096}}, data, 0);
+  expect_write(mock_image_ctx, CEPH_NOSNAP, ictx->get_object_name(0), 0);
+
+  req = new MockCopyupRequest(&mock_image_ctx, 0, {{0, 4096}}, {});
+  mock_image_ctx.copyup_list[0] = req;
+  req->append_request(&mock_write_request2, {{0, 1024}});
+  req->send();
+
+  ASSERT_EQ(0, mock_write_request2.ctx.wait());
+}
+
+TEST_F(TestMockIoCopyupRequest, ProcessCopyupWriteAppendedAfterPrune) {
+  REQUIRE_FEATURE(RBD_FEATURE_LAYERING);
+
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockTestImageCtx mock_parent_image_ctx(*ictx->parent);
+  MockTestImageCtx mock_image_ctx(*ictx, &mock_parent_image_ctx);
+
+  MockExclusiveLock mock_exclusive_lock;
+  MockJournal mock_journal;
+  MockObjectMap mock_object_map;
+  initialize_features(ictx, mock_image_ctx, mock_exclusive_lock, mock_journal,
+                      mock_object_map);
+
+  expect_op_work_queue(mock_image_ctx);
+  expect_is_lock_owner(mock_image_ctx);
+
+  InSequence seq;
+
+  auto req = new MockCopyupRequest(&mock_image_ctx, 0,
+                                   {{0, 4096}}, {});
+
+  // a second write-op joins once the pruned parent read is in flight
+  MockAbstractObjectWriteRequest mock_write_request1;
+  MockAbstractObjectWriteRequest mock_write_request2;
+  std::string data = std::string(1024, '1') + std::string(1024, '2') +
+                     std::string(1024, '3');
+  expect_read_parent(mock_parent_image_ctx, {{1024, 3072}}, data, 0,
+                     [req, &mock_write_request2]() {
+                       req->append_request(&mock_write_request2,
+                                           {{2048, 1024}});
+                     });
+
+  // the parent data overwritten by the second write-op is dropped
+  bufferlist in_prepare_bl1;
+  in_prepare_bl1.append(data.substr(0, 1024));
+  bufferlist in_prepare_bl2;
+  in_prepare_bl2.append(data.substr(2048, 1024));
+  expect_prepare_copyup(
+    mock_image_ctx,
+    {{1024, {1024, {SPARSE_EXTENT_STATE_DATA, 1024,
+                    bufferlist{in_prepare_bl1}}}},
+     {3072, {1024, {SPARSE_EXTENT_STATE_DATA, 1024,
+                    bufferlist{in_prepare_bl2}}}}},
+    {{1024, {1024, {SPARSE_EXTENT_STATE_DATA, 1024,
+                    bufferlist{in_prepare_bl1}}}},
+     {3072, {1024, {SPARSE_EXTENT_STATE_DATA, 1024,
+                    bufferlist{in_prepare_bl2}}}}});
+
+  expect_get_pre_write_object_map_state(mock_image_ctx, mock_write_request2,
+                                        OBJECT_EXISTS);
+  expect_object_map_at(mock_image_ctx, 0, OBJECT_NONEXISTENT);
+  expect_object_map_update(mock_image_ctx, CEPH_NOSNAP, 0, OBJECT_EXISTS, true,
+                           0);
+
+  expect_add_copyup_ops(mock_write_request1);
+  expect_add_copyup_ops(mock_write_request2);
+  expect_sparse_copyup(mock_image_ctx, CEPH_NOSNAP, ictx->get_object_name(0),
+                       {{1024, 1024}, {3072, 1024}},
+                       data.substr(0, 1024) + data.substr(2048, 1024), 0);
+  expect_write(mock_image_ctx, CEPH_NOSNAP, ictx->get_object_name(0), 0);
+
+  mock_image_ctx.copyup_list[0] = req;
+  req->append_request(&mock_write_request1, {{0, 1024}});
+  req->send();
+
+  ASSERT_EQ(0, mock_write_request1.ctx.wait());
+  ASSERT_EQ(0, mock_write_request2.ctx.wait());
+}
+
 } // namespace io
 } // namespace librbd
@@ -4,85 +4,156 @@
 #include "test/librbd/test_mock_fixture.h"
 #include "test/librbd/test_support.h"
 #include "test/librbd/mock/MockImageCtx.h"
-#include "test/librbd/mock/exclusive_lock/MockPolicy.h"
-#include "librbd/io/ImageDispatchSpec.h"
-#include "librbd/io/ImageRequestWQ.h"
-#include "librbd/io/ImageRequest.h"
+#include "include/rbd/librbd.hpp"
+#include "librbd/io/QosImageDispatch.h"
 
 namespace librbd {
-namespace io {
+namespace {
 
-TEST_F(TestMockIoImageRequestWQ, QosNoLimit) {
-  librbd::ImageCtx *ictx;
-  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+struct MockTestImageCtx : public MockImageCtx {
+  MockTestImageCtx(ImageCtx &image_ctx) : MockImageCtx(image_ctx) {
+  }
+};
 
-  MockTestImageCtx mock_image_ctx(*ictx);
+} // anonymous namespace
 
-  MockImageDispatchSpec mock_queued_image_request;
-  expect_was_throttled(mock_queued_image_request, false);
-  expect_set_throttled(mock_queued_image_request);
+namespace io {
 
-  InSequence seq;
-  MockImageRequestWQ mock_image_request_wq(&mock_image_ctx, "io", 60, nullptr);
+template <>
+struct FlushTracker<MockTestImageCtx> {
+  FlushTracker(MockTestImageCtx*) {
+  }
 
-  mock_image_request_wq.apply_qos_limit(IMAGE_DISPATCH_FLAG_QOS_BPS_THROTTLE, 0,
-                                        0, 1);
+  void shut_down() {
+  }
 
-  expect_front(mock_image_request_wq, &mock_queued_image_request);
-  expect_is_refresh_request(mock_image_ctx, false);
-  expect_is_write_op(mock_queued_image_request, true);
-  expect_dequeue(mock_image_request_wq, &mock_queued_image_request);
-  ASSERT_TRUE(mock_image_request_wq.invoke_dequeue() == &mock_queued_image_request);
-}
+  void flush(Context*) {
+  }
 
-TEST_F(TestMockIoImageRequestWQ, BPSQosNoBurst) {
-  librbd::ImageCtx *ictx;
-  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+  void start_io(uint64_t) {
+  }
 
-  MockTestImageCtx mock_image_ctx(*ictx);
+  void finish_io(uint64_t) {
+  }
 
-  MockImageDispatchSpec mock_queued_image_request;
-  expect_was_throttled(mock_queued_image_request, false);
-  expect_set_throttled(mock_queued_image_request);
+};
 
-  InSequence seq;
-  MockImageRequestWQ mock_image_request_wq(&mock_image_ctx, "io", 60, nullptr);
+} // namespace io
+} // namespace librbd
 
-  mock_image_request_wq.apply_qos_limit(IMAGE_DISPATCH_FLAG_QOS_BPS_THROTTLE, 1,
-                                        0, 1);
+#include "librbd/io/QosImageDispatch.cc"
 
-  expect_front(mock_image_request_wq, &mock_queued_image_request);
-  expect_tokens_requested(mock_queued_image_request, 2, true);
-  expect_dequeue(mock_image_request_wq, &mock_queued_image_request);
-  expect_all_throttled(mock_queued_image_request, true);
-  expect_requeue_back(mock_image_request_wq);
-  expect_signal(mock_image_request_wq);
-  ASSERT_TRUE(mock_image_request_wq.invoke_dequeue() == nullptr);
-}
+namespace librbd {
+namespace io {
 
-TEST_F(TestMockIoImageRequestWQ, BPSQosWithBurst) {
+struct TestMockIoQosImageDispatch : public TestMockFixture {
+  typedef QosImageDispatch<librbd::MockTestImageCtx> MockQosImageDispatch;
+
+  bool read(MockQosImageDispatch &qos_image_dispatch, uint64_t tid,
+            std::atomic<uint32_t> *image_dispatch_flags,
+            Context *on_dispatched) {
+    DispatchResult dispatch_result;
+    Context *on_finish = nullptr;
+    return qos_image_dispatch.read(
+      nullptr, {{0, 4096}}, ReadResult{}, {}, 0, 0, {}, tid,
+      image_dispatch_flags, &dispatch_result, &on_finish, on_dispatched);
+  }
+};
+
+TEST_F(TestMockIoQosImageDispatch, PoolLimitSharedByImages) {
   librbd::ImageCtx *ictx;
   ASSERT_EQ(0, open_image(m_image_name, &ictx));
 
-  MockTestImageCtx mock_image_ctx(*ictx);
+  MockTestImageCtx mock_image_ctx1(*ictx);
+  MockTestImageCtx mock_image_ctx2(*ictx);
+  MockQosImageDispatch qos_image_dispatch1(&mock_image_ctx1);
+  MockQosImageDispatch qos_image_dispatch2(&mock_image_ctx2);
+
+  // both images are refreshed with the same pool-level limit of 1 IO/s
+  qos_image_dispatch1.apply_qos_limit(
+    IMAGE_DISPATCH_FLAG_QOS_POOL_IOPS_THROTTLE, 1, 0, 1);
+  qos_image_dispatch2.apply_qos_limit(
+    IMAGE_DISPATCH_FLAG_QOS_POOL_IOPS_THROTTLE, 1, 0, 1);
+
+  std::atomic<uint32_t> image_dispatch_flags1{0};
+  C_SaferCond on_dispatched1;
+  ASSERT_FALSE(read(qos_image_dispatch1, 1, &image_dispatch_flags1,
+                    &on_dispatched1));
+
+  // the second image draws from the same, now empty, bucket
+  std::atomic<uint32_t> image_dispatch_flags2{0};
+  C_SaferCond on_dispatched2;
+  ASSERT_TRUE(read(qos_image_dispatch2, 2, &image_dispatch_flags2,
+                   &on_dispatched2));
+
+  ASSERT_EQ(0, on_dispatched2.wait());
+  ASSERT_EQ(IMAGE_DISPATCH_FLAG_QOS_MASK,
+            image_dispatch_flags2 & IMAGE_DISPATCH_FLAG_QOS_MASK);
+
+  qos_image_dispatch1.apply_qos_limit(
+    IMAGE_DISPATCH_FLAG_QOS_POOL_IOPS_THROTTLE, 0, 0, 1);
+  qos_image_dispatch2.apply_qos_limit(
+    IMAGE_DISPATCH_FLAG_QOS_POOL_IOPS_THROTTLE, 0, 0, 1);
+}
 
-  MockImageDispatchSpec mock_queued_image_request;
-  expect_was_throttled(mock_queued_image_request, false);
-  expect_set_throttled(mock_queued_image_request);
+TEST_F(TestMockIoQosImageDispatch, PoolLimitNotReappliedOnRefresh) {
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
 
-  InSequence seq;
-  MockImageRequestWQ mock_image_request_wq(&mock_image_ctx, "io", 60, nullptr);
+  MockTestImageCtx mock_image_ctx1(*ictx);
+  MockTestImageCtx mock_image_ctx2(*ictx);
+  MockQosImageDispatch qos_image_dispatch1(&mock_image_ctx1);
+  MockQosImageDispatch qos_image_dispatch2(&mock_image_ctx2);
+
+  qos_image_dispatch1.apply_qos_limit(
+    IMAGE_DISPATCH_FLAG_QOS_POOL_IOPS_THROTTLE, 1, 0, 1);
+
+  std::atomic<uint32_t> image_dispatch_flags1{0};
+  C_SaferCond on_dispatched1;
+  ASSERT_FALSE(read(qos_image_dispatch1, 1, &image_dispatch_flags1,
+                    &on_dispatched1));
+
+  // refreshing another image with the unchanged limit must not reset the
+  // shared bucket and hand out a fresh token
+  qos_image_dispatch2.apply_qos_limit(
+    IMAGE_DISPATCH_FLAG_QOS_POOL_IOPS_THROTTLE, 1, 0, 1);
+  qos_image_dispatch2.apply_qos_schedule_tick_min(50);
+
+  std::atomic<uint32_t> image_dispatch_flags2{0};
+  C_SaferCond on_dispatched2;
+  ASSERT_TRUE(read(qos_image_dispatch2, 2, &image_dispatch_flags2,
+                   &on_dispatched2));
+  ASSERT_EQ(0, on_dispatched2.wait());
+
+  qos_image_dispatch1.apply_qos_limit(
+    IMAGE_DISPATCH_FLAG_QOS_POOL_IOPS_THROTTLE, 0, 0, 1);
+  qos_image_dispatch2.apply_qos_limit(
+    IMAGE_DISPATCH_FLAG_QOS_POOL_IOPS_THROTTLE, 0, 0, 1);
+}
 
-  mock_image_request_wq.apply_qos_limit(IMAGE_DISPATCH_FLAG_QOS_BPS_THROTTLE, 1,
-                                        1, 1);
+TEST_F(TestMockIoQosImageDispatch, ImageLimitNotShared) {
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
 
-  expect_front(mock_image_request_wq, &mock_queued_image_request);
-  expect_tokens_requested(mock_queued_image_request, 2, true);
-  expect_dequeue(mock_image_request_wq, &mock_queued_image_request);
-  expect_all_throttled(mock_queued_image_request, true);
-  expect_requeue_back(mock_image_request_wq);
-  expect_signal(mock_image_request_wq);
-  ASSERT_TRUE(mock_image_request_wq.invoke_dequeue() == nullptr);
+  MockTestImageCtx mock_image_ctx1(*ictx);
+  MockTestImageCtx mock_image_ctx2(*ictx);
+  MockQosImageDispatch qos_image_dispatch1(&mock_image_ctx1);
+  MockQosImageDispatch qos_image_dispatch2(&mock_image_ctx2);
+
+  qos_image_dispatch1.apply_qos_limit(
+    IMAGE_DISPATCH_FLAG_QOS_IOPS_THROTTLE, 1, 0, 1);
+  qos_image_dispatch2.apply_qos_limit(
+    IMAGE_DISPATCH_FLAG_QOS_IOPS_THROTTLE, 1, 0, 1);
+
+  // each image has a token of its own
+  std::atomic<uint32_t> image_dispatch_flags1{0};
+  C_SaferCond on_dispatched1;
+  ASSERT_FALSE(read(qos_image_dispatch1, 1, &image_dispatch_flags1,
+                    &on_dispatched1));
+  std::atomic<uint32_t> image_dispatch_flags2{0};
+  C_SaferCond on_dispatched2;
+  ASSERT_FALSE(read(qos_image_dispatch2, 2, &image_dispatch_flags2,
+                    &on_dispatched2));
 }
 
 } // namespace io
@@ -89,6 +89,24 @@ struct TestMockIoSimpleSchedulerObjectDispatch : public TestMockFixture {
                 }));
   }
 
+  void expect_dispatch_delayed_write(MockTestImageCtx &mock_image_ctx,
+                                     uint64_t object_off,
+                                     const std::string &data, int r) {
+    EXPECT_CALL(*mock_image_ctx.io_object_dispatcher, send(_))
+      .WillOnce(Invoke([&mock_image_ctx, object_off, data, r](
+                           ObjectDispatchSpec* spec) {
+                  auto write = boost::get<ObjectDispatchSpec::WriteRequest>(
+                    &spec->request);
+                  ASSERT_TRUE(write != nullptr);
+                  ASSERT_EQ(object_off, write->object_off);
+                  ASSERT_EQ(data, write->data.to_str());
+
+                  spec->dispatch_result = io::DISPATCH_RESULT_COMPLETE;
+                  mock_image_ctx.image_ctx->op_work_queue->queue(
+                      &spec->dispatcher_ctx, r);
+                }));
+  }
+
   void expect_cancel_timer_task(Context *timer_task) {
       EXPECT_CALL(m_mock_timer, cancel_event(timer_task))
         .WillOnce(Invoke([](Context *timer_task) {
@@ -464,7 +482,7 @@ TEST_F(TestMockIoSimpleSchedulerObjectDispatch, WriteMerged) {
   ASSERT_EQ(0, cond6.wait());
 }
 
-TEST_F(TestMockIoSimpleSchedulerObjectDispatch, WriteNonSequential) {
+TEST_F(TestMockIoSimpleSchedulerObjectDispatch, WriteNotMergeable) {
   librbd::ImageCtx *ictx;
   ASSERT_EQ(0, open_image(m_image_name, &ictx));
 
@@ -507,24 +525,112 @@ TEST_F(TestMockIoSimpleSchedulerObjectDispatch, WriteNonSequential) {
   expect_dispatch_delayed_requests(mock_image_ctx, 0);
   expect_schedule_dispatch_delayed_requests(timer_task, nullptr);
 
+  // different op flags prevent merging with the delayed write
   object_off = 5;
   data.clear();
   data.append(std::string(10, 'Y'));
   C_SaferCond cond3;
   Context *on_finish3 = &cond3;
   ASSERT_FALSE(mock_simple_scheduler_object_dispatch.write(
+      0, object_off, std::move(data), mock_image_ctx.get_data_io_context(),
+      LIBRADOS_OP_FLAG_FADVISE_DONTNEED, 0, std::nullopt, {},
+      &object_dispatch_flags, nullptr, &dispatch_result, &on_finish3,
+      nullptr));
+  ASSERT_NE(on_finish3, &cond3);
+
+  on_finish1->complete(0);
+  ASSERT_EQ(0, cond1.wait());
+  ASSERT_EQ(0, on_dispatched2.wait());
+  on_finish2->complete(0);
+  ASSERT_EQ(0, cond2.wait());
+  on_finish3->complete(0);
+  ASSERT_EQ(0, cond3.wait());
+}
+
+TEST_F(TestMockIoSimpleSchedulerObjectDispatch, WriteOverlapped) {
+  librbd::ImageCtx *ictx;
+  ASSERT_EQ(0, open_image(m_image_name, &ictx));
+
+  MockTestImageCtx mock_image_ctx(*ictx);
+  MockSimpleSchedulerObjectDispatch
+      mock_simple_scheduler_object_dispatch(&mock_image_ctx);
+
+  expect_get_object_name(mock_image_ctx, 0);
+
+  InSequence seq;
+
+  ceph::bufferlist data;
+  int object_dispatch_flags = 0;
+  C_SaferCond cond1;
+  Context *on_finish1 = &cond1;
+  ASSERT_FALSE(mock_simple_scheduler_object_dispatch.write(
+      0, 0, std::move(data), mock_image_ctx.get_data_io_context(), 0, 0,
+      std::nullopt, {}, &object_dispatch_flags, nullptr, nullptr, &on_finish1,
+      nullptr));
+  ASSERT_NE(on_finish1, &cond1);
+
+  Context *timer_task = nullptr;
+  expect_schedule_dispatch_delayed_requests(nullptr, &timer_task);
+
+  uint64_t object_off = 0;
+  data.clear();
+  data.append(std::string(10, 'X'));
+  io::DispatchResult dispatch_result;
+  C_SaferCond cond2;
+  Context *on_finish2 = &cond2;
+  C_SaferCond on_dispatched2;
+  ASSERT_TRUE(mock_simple_scheduler_object_dispatch.write(
+      0, object_off, std::move(data), mock_image_ctx.get_data_io_context(), 0,
+      0, std::nullopt, {}, &object_dispatch_flags, nullptr, &dispatch_result,
+      &on_finish2, &on_dispatched2));
+  ASSERT_EQ(dispatch_result, io::DISPATCH_RESULT_COMPLETE);
+  ASSERT_NE(on_finish2, &cond2);
+  ASSERT_NE(timer_task, nullptr);
+
+  object_off = 20;
+  data.clear();
+  data.append(std::string(10, 'Z'));
+  C_SaferCond cond3;
+  Context *on_finish3 = &cond3;
+  C_SaferCond on_dispatched3;
+  ASSERT_TRUE(mock_simple_scheduler_object_dispatch.write(
       0, object_off, std::move(data), mock_image_ctx.get_data_io_context(), 0,
       0, std::nullopt, {}, &object_dispatch_flags, nullptr, &dispatch_result,
-      &on_finish3, nullptr));
+      &on_finish3, &on_dispatched3));
+  ASSERT_EQ(dispatch_result, io::DISPATCH_RESULT_COMPLETE);
   ASSERT_NE(on_finish3, &cond3);
 
+  // overwrites the tail of 0~10 and fills the gap up to 20~10
+  object_off = 5;
+  data.clear();
+  data.append(std::string(15, 'Y'));
+  C_SaferCond cond4;
+  Context *on_finish4 = &cond4;
+  C_SaferCond on_dispatched4;
+  ASSERT_TRUE(mock_simple_scheduler_object_dispatch.write(
+      0, object_off, std::move(data), mock_image_ctx.get_data_io_context(), 0,
+      0, std::nullopt, {}, &object_dispatch_flags, nullptr, &dispatch_result,
+      &on_finish4, &on_dispatched4));
+  ASSERT_EQ(dispatch_result, io::DISPATCH_RESULT_COMPLETE);
+  ASSERT_NE(on_finish4, &cond4);
+
+  // expect a single request dispatched: 0~30
+  expect_dispatch_delayed_write(
+    mock_image_ctx, 0,
+    std::string(5, 'X') + std::string(15, 'Y') + std::string(10, 'Z'), 0);
+  expect_schedule_dispatch_delayed_requests(timer_task, nullptr);
+
   on_finish1->complete(0);
   ASSERT_EQ(0, cond1.wait());
   ASSERT_EQ(0, on_dispatched2.wait());
+  ASSERT_EQ(0, on_dispatched3.wait());
+  ASSERT_EQ(0, on_dispatched4.wait());
   on_finish2->complete(0);
-  ASSERT_EQ(0, cond2.wait());
   on_finish3->complete(0);
+  on_finish4->complete(0);
+  ASSERT_EQ(0, cond2.wait());
   ASSERT_EQ(0, cond3.wait());
+  ASSERT_EQ(0, cond4.wait());
 }
 
 TEST_F(TestMockIoSimpleSchedulerObjectDispatch, Mixed) {
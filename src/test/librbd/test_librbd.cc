@@ -35,6 +35,7 @@
 #include <algorithm>
 #include <chrono>
 #include <condition_variable>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <list>
@@ -4618,6 +4619,59 @@ TYPED_TEST(DiffIterateTest, DiffIterateParentDiscard)
   ASSERT_TRUE(two.subset_of(diff));
 }
 
+TYPED_TEST(DiffIterateTest, DiffIterateFastDiffSkipsUnchanged)
+{
+  REQUIRE_FEATURE(RBD_FEATURE_FAST_DIFF);
+
+  librados::IoCtx ioctx;
+  ASSERT_EQ(0, this->_rados.ioctx_create(this->m_pool_name.c_str(), ioctx));
+
+  librbd::RBD rbd;
+  librbd::Image image;
+  std::string name = this->get_temp_image_name();
+  uint64_t size = 20 << 20;
+  int order = 0;
+
+  ASSERT_EQ(0, create_image_pp(rbd, ioctx, name.c_str(), size, &order));
+  ASSERT_EQ(0, rbd.open(ioctx, image, name.c_str(), NULL));
+
+  uint64_t object_size = 1 << order;
+  uint64_t diff_object_size = 0;
+  if (this->whole_object) {
+    diff_object_size = object_size;
+  }
+
+  bufferlist bl;
+  bl.append(std::string(256, '1'));
+  for (uint64_t object_no = 0; object_no < 3; ++object_no) {
+    ASSERT_EQ(256, image.write(object_no * object_size, 256, bl));
+  }
+  ASSERT_EQ(0, image.snap_create("one"));
+
+  std::vector<librbd::snap_info_t> snaps;
+  ASSERT_EQ(0, image.snap_list(snaps));
+  ASSERT_EQ(1U, snaps.size());
+
+  // only object 1 is updated through librbd
+  ASSERT_EQ(256, image.write(object_size + 4096, 256, bl));
+
+  // object 2 is updated behind the object map's back: its fast-diff state
+  // stays unchanged, but list_snaps would report the new extent
+  std::ostringstream oid;
+  oid << image.get_block_name_prefix() << "." << std::hex
+      << std::setw(16) << std::setfill('0') << 2;
+  std::vector<librados::snap_t> snapc = {snaps[0].id};
+  ASSERT_EQ(0, ioctx.selfmanaged_snap_set_write_ctx(snaps[0].id, snapc));
+  ASSERT_EQ(0, ioctx.write(oid.str(), bl, bl.length(), 4096));
+
+  std::vector<diff_extent> extents;
+  ASSERT_EQ(0, image.diff_iterate2("one", 0, size, true, this->whole_object,
+                                   vector_iterate_cb, (void *) &extents));
+  ASSERT_EQ(1u, extents.size());
+  ASSERT_EQ(diff_extent(object_size + 4096, 256, true, diff_object_size),
+            extents[0]);
+}
+
 TEST_F(TestLibRBD, ZeroLengthWrite)
 {
   rados_ioctx_t ioctx;
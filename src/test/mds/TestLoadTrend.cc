@@ -0,0 +1,121 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+
+#include <cmath>
+#include <functional>
+
+#include "mds/LoadTrend.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+// defaults of mds_decay_halflife and mds_bal_split_rd
+constexpr double halflife = 5.0;
+constexpr double split_rd = 25000;
+
+struct ReplayResult {
+  double reactive = -1;   // when the decayed load itself crossed split_rd
+  double predicted = -1;  // when the trend projected it would
+};
+
+/*
+ * Replay a request rate trace (requests/s as a function of time) through
+ * a decaying popularity counter, the way MDBalancer::hit_dir sees it, and
+ * record when a fixed threshold and the trend predictor would each have
+ * asked for a split.
+ */
+ReplayResult replay(const std::function<double(double)>& rate,
+                    double duration, double step, double horizon)
+{
+  ReplayResult res;
+  LoadTrend trend;
+  double pop = 0;
+  const double decay = std::exp(-std::log(2) / halflife * step);
+  for (double t = 0; t < duration; t += step) {
+    pop = pop * decay + rate(t) * step;
+    if (pop >= split_rd / 2)
+      trend.sample(t, pop);
+    if (res.reactive < 0 && pop > split_rd)
+      res.reactive = t;
+    if (res.predicted < 0 && trend.is_primed() &&
+        trend.predict(horizon) > split_rd)
+      res.predicted = t;
+  }
+  return res;
+}
+
+}
+
+TEST(MDSLoadTrend, Steady)
+{
+  LoadTrend trend;
+  for (int t = 0; t < 60; ++t)
+    trend.sample(t, 1000);
+  ASSERT_NEAR(1000, trend.predict(10), 1e-6);
+  ASSERT_NEAR(0, trend.get_trend(), 1e-6);
+}
+
+TEST(MDSLoadTrend, IgnoresCloseSamples)
+{
+  LoadTrend trend(0.5, 0.3, 1.0);
+  ASSERT_TRUE(trend.sample(0, 100));
+  ASSERT_FALSE(trend.sample(0.5, 10000));
+  ASSERT_EQ(100, trend.get_level());
+  ASSERT_TRUE(trend.sample(1.0, 200));
+  ASSERT_GT(trend.get_trend(), 0);
+}
+
+TEST(MDSLoadTrend, Cooling)
+{
+  LoadTrend trend;
+  double pop = 30000;
+  const double decay = std::exp(-std::log(2) / halflife);
+  for (int t = 0; t < 100; ++t) {
+    pop *= decay;
+    trend.sample(t, pop);
+    ASSERT_GE(trend.predict(10), 0);
+    if (t > 0) {
+      ASSERT_LE(trend.predict(10), pop);
+    }
+  }
+}
+
+TEST(MDSLoadTrend, HotDirectoryIsPredicted)
+{
+  // quiet directory that suddenly becomes hot: 50 req/s, then a ramp of
+  // +100 req/s every second up to 5000 req/s
+  auto rate = [](double t) {
+    return t < 30 ? 50 : std::min(50 + (t - 30) * 100, 5000.0);
+  };
+  for (double step : {0.1, 1.0}) {
+    auto res = replay(rate, 120, step, 10);
+    ASSERT_GT(res.reactive, 0);
+    ASSERT_GT(res.predicted, 0);
+    // split well before the fixed threshold would have fired
+    ASSERT_LE(res.predicted + 5, res.reactive);
+  }
+}
+
+TEST(MDSLoadTrend, WarmPlateauIsNotPredicted)
+{
+  // a warm directory that levels off below the split threshold must not
+  // be split just because it warmed up
+  auto rate = [](double t) {
+    return t < 30 ? 50 : std::min(50 + (t - 30) * 100, 3000.0);
+  };
+  for (double step : {0.1, 1.0}) {
+    auto res = replay(rate, 300, step, 10);
+    ASSERT_LT(res.reactive, 0);
+    ASSERT_LT(res.predicted, 0);
+  }
+}
@@ -0,0 +1,198 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "osdc/OpBatch.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+struct Msg {
+  int seq;
+};
+
+// minimal stand-in for ceph::timer: events run only when the test fires
+// them, and a fired event can no longer be cancelled
+struct FakeTimer {
+  std::map<uint64_t, std::function<void()>> events;
+  uint64_t next_id = 0;
+  // fire each event before add_event() returns, as a timer thread may do
+  // with a very short delay
+  bool fire_on_add = false;
+
+  template <typename Duration, typename Callable>
+  uint64_t add_event(Duration, Callable&& f) {
+    if (fire_on_add) {
+      f();
+      return ++next_id;
+    }
+    events.emplace(++next_id, std::forward<Callable>(f));
+    return next_id;
+  }
+  bool cancel_event(uint64_t id) {
+    return events.erase(id) > 0;
+  }
+  // take the event off the schedule, as the timer thread does before
+  // running it; the returned callable runs it
+  std::function<void()> start(uint64_t id) {
+    auto f = std::move(events.at(id));
+    events.erase(id);
+    return f;
+  }
+};
+
+struct Session {
+  OpBatch<Msg> batch;
+  std::vector<int> sent;
+  int refs = 0;
+  int flushes = 0;
+
+  void flush(FakeTimer& timer) {
+    if (batch.disarm(timer)) {
+      --refs;
+    }
+    for (auto m : batch.take()) {
+      sent.push_back(m->seq);
+    }
+    ++flushes;
+  }
+
+  void queue(FakeTimer& timer, Msg *m) {
+    batch.push(m);
+    if (!batch.is_armed()) {
+      ++refs;
+      batch.arm(timer, std::chrono::microseconds(100),
+                [this, &timer](OpBatch<Msg>::event_ref id) {
+                  if (batch.fired(id)) {
+                    flush(timer);
+                  }
+                  --refs;
+                });
+    }
+  }
+};
+
+}
+
+TEST(OpBatch, FlushOnTimer)
+{
+  FakeTimer timer;
+  Session s;
+  Msg a{1}, b{2}, c{3};
+
+  s.queue(timer, &a);
+  s.queue(timer, &b);
+  s.queue(timer, &c);
+  ASSERT_EQ(3u, s.batch.size());
+  ASSERT_TRUE(s.batch.is_armed());
+  ASSERT_EQ(1u, timer.events.size());
+  ASSERT_EQ(1, s.refs);
+
+  timer.start(s.batch.get_flush_event())();
+  ASSERT_FALSE(s.batch.is_armed());
+  ASSERT_TRUE(s.batch.empty());
+  ASSERT_EQ((std::vector<int>{1, 2, 3}), s.sent);
+  ASSERT_EQ(0, s.refs);
+}
+
+TEST(OpBatch, ExplicitFlushCancelsTimer)
+{
+  FakeTimer timer;
+  Session s;
+  Msg a{1};
+
+  s.queue(timer, &a);
+  s.flush(timer);
+  ASSERT_EQ((std::vector<int>{1}), s.sent);
+  ASSERT_FALSE(s.batch.is_armed());
+  ASSERT_TRUE(timer.events.empty());
+  ASSERT_EQ(0, s.refs);
+}
+
+TEST(OpBatch, Discard)
+{
+  FakeTimer timer;
+  OpBatch<Msg> batch;
+  Msg a{1}, b{2};
+
+  batch.push(&a);
+  batch.push(&b);
+  batch.arm(timer, std::chrono::microseconds(100),
+            [](OpBatch<Msg>::event_ref) {});
+  ASSERT_TRUE(batch.disarm(timer));
+  ASSERT_TRUE(timer.events.empty());
+  auto msgs = batch.take();
+  ASSERT_EQ(2u, msgs.size());
+  ASSERT_EQ(&a, msgs[0]);
+  ASSERT_EQ(&b, msgs[1]);
+  ASSERT_TRUE(batch.empty());
+  ASSERT_FALSE(batch.disarm(timer));
+}
+
+TEST(OpBatch, StaleCallbackKeepsNewEvent)
+{
+  FakeTimer timer;
+  Session s;
+  Msg a{1}, b{2};
+
+  s.queue(timer, &a);
+  uint64_t first = s.batch.get_flush_event();
+
+  // the timer starts running the first event, but the session lock is
+  // held by a flush: cancelling fails and the callback still owns its ref
+  auto stale = timer.start(first);
+  s.flush(timer);
+  ASSERT_EQ(1, s.refs);
+
+  // a new op re-arms the batch before the stale callback gets the lock
+  s.queue(timer, &b);
+  uint64_t second = s.batch.get_flush_event();
+  ASSERT_NE(first, second);
+  ASSERT_EQ(2, s.refs);
+
+  stale();
+  ASSERT_TRUE(s.batch.is_armed());
+  ASSERT_EQ(second, s.batch.get_flush_event());
+  ASSERT_EQ(1u, s.batch.size());
+  ASSERT_EQ(1, s.refs);
+
+  // the new event can still be cancelled when the session goes away
+  ASSERT_TRUE(s.batch.disarm(timer));
+  ASSERT_TRUE(timer.events.empty());
+}
+
+TEST(OpBatch, EventFiresBeforeArmReturns)
+{
+  FakeTimer timer;
+  timer.fire_on_add = true;
+  OpBatch<Msg> batch;
+  Msg a{1};
+  int flushes = 0;
+  // callbacks waiting for the owner's lock, held by the arming thread
+  std::vector<std::function<void()>> waiting;
+
+  batch.push(&a);
+  batch.arm(timer, std::chrono::microseconds(0),
+            [&](OpBatch<Msg>::event_ref id) {
+              waiting.push_back([&, id] {
+                if (batch.fired(id)) {
+                  batch.take();
+                  ++flushes;
+                }
+              });
+            });
+  ASSERT_EQ(1u, waiting.size());
+  ASSERT_TRUE(batch.is_armed());
+
+  // the owner's lock is released: the callback must still recognize its
+  // event and flush
+  waiting.front()();
+  ASSERT_EQ(1, flushes);
+  ASSERT_FALSE(batch.is_armed());
+  ASSERT_TRUE(batch.empty());
+}
@@ -235,6 +235,29 @@ TEST_F(TestMockThrottler, Decrease_Max_Concurrent_Syncs) {
   throttler.finish_op("ns", "id5");
 }
 
+TEST_F(TestMockThrottler, Scale_Max_Concurrent_Syncs) {
+  MockThrottler throttler(g_ceph_context, "rbd_mirror_concurrent_image_syncs");
+  throttler.set_max_concurrent_ops(1);
+
+  C_SaferCond on_start1;
+  throttler.start_op("ns", "id1", &on_start1);
+  C_SaferCond on_start2;
+  throttler.start_op("ns", "id2", &on_start2);
+  C_SaferCond on_start3;
+  throttler.start_op("ns", "id3", &on_start3);
+
+  ASSERT_EQ(0, on_start1.wait());
+
+  throttler.set_scale(2);
+  ASSERT_EQ(0, on_start2.wait());
+
+  throttler.set_scale(1);
+  throttler.finish_op("ns", "id1");
+  throttler.finish_op("ns", "id2");
+  ASSERT_EQ(0, on_start3.wait());
+  throttler.finish_op("ns", "id3");
+}
+
 TEST_F(TestMockThrottler, Drain) {
   MockThrottler throttler(g_ceph_context, "rbd_mirror_concurrent_image_syncs");
   throttler.set_max_concurrent_ops(1);
@@ -216,7 +216,15 @@ int ObjectCacheStore::handle_promote_callback(int ret, bufferlist* read_buf,
       return -ENOSPC;
     }
 
-    ret = read_buf->write_file(cache_file_path.c_str());
+    // write to a temporary file and rename it into place so that clients
+    // which memory-map cache files never observe a file being rewritten
+    std::string tmp_file_path = cache_file_path + ".tmp";
+    ret = read_buf->write_file(tmp_file_path.c_str());
+    if (ret == 0 && std::rename(tmp_file_path.c_str(),
+                                cache_file_path.c_str()) < 0) {
+      ret = -errno;
+      std::remove(tmp_file_path.c_str());
+    }
     if (ret < 0) {
       lderr(m_cct) << "fail to write cache file" << dendl;
 
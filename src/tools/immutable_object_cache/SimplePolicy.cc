@@ -76,7 +76,8 @@ cache_status_t SimplePolicy::lookup_object(std::string file_name) {
 
   if (entry->status == OBJ_CACHE_PROMOTED || entry->status == OBJ_CACHE_DNE) {
     // bump pos in lru on hit
-    m_promoted_lru.lru_touch(entry);
+    std::lock_guard lru_locker{m_lru_lock};
+    lru_touch(entry);
   }
 
   return entry->status;
@@ -108,7 +109,8 @@ void SimplePolicy::update_status(std::string file_name,
   // promoting done
   if (entry->status == OBJ_CACHE_SKIP && (new_status== OBJ_CACHE_PROMOTED ||
                                           new_status== OBJ_CACHE_DNE)) {
-    m_promoted_lru.lru_insert_top(entry);
+    m_probation_lru.lru_insert_top(entry);
+    entry->lru_segment = LRU_SEGMENT_PROBATION;
     entry->status = new_status;
     entry->size = size;
     m_cache_size += entry->size;
@@ -137,7 +139,7 @@ void SimplePolicy::update_status(std::string file_name,
     entry->size = 0;
     entry->status = new_status;
 
-    m_promoted_lru.lru_remove(entry);
+    lru_remove(entry);
     m_cache_map.erase(entry_it);
     m_cache_size -= size;
     delete entry;
@@ -174,10 +176,11 @@ void SimplePolicy::get_evict_list(std::list<std::string>* obj_list) {
     // TODO(dehao): make this configurable
     int evict_num = m_cache_map.size() * 0.1;
     for (int i = 0; i < evict_num; i++) {
-      Entry* entry = reinterpret_cast<Entry*>(m_promoted_lru.lru_expire());
+      Entry* entry = lru_get_next_expire();
       if (entry == nullptr) {
         continue;
       }
+      lru_remove(entry);
       std::string file_name = entry->file_name;
       obj_list->push_back(file_name);
     }
@@ -201,16 +204,71 @@ uint64_t SimplePolicy::get_promoting_entry_num() {
 }
 
 uint64_t SimplePolicy::get_promoted_entry_num() {
-  return m_promoted_lru.lru_get_size();
+  return m_probation_lru.lru_get_size() + m_protected_lru.lru_get_size();
+}
+
+uint64_t SimplePolicy::get_protected_entry_num() {
+  return m_protected_lru.lru_get_size();
 }
 
 std::string SimplePolicy::get_evict_entry() {
-  Entry* entry = reinterpret_cast<Entry*>(m_promoted_lru.lru_get_next_expire());
+  Entry* entry = lru_get_next_expire();
   if (entry == nullptr) {
     return "";
   }
   return entry->file_name;
 }
 
+void SimplePolicy::lru_remove(Entry* entry) {
+  switch (entry->lru_segment) {
+  case LRU_SEGMENT_PROBATION:
+    m_probation_lru.lru_remove(entry);
+    break;
+  case LRU_SEGMENT_PROTECTED:
+    m_protected_lru.lru_remove(entry);
+    break;
+  default:
+    break;
+  }
+  entry->lru_segment = LRU_SEGMENT_NONE;
+}
+
+void SimplePolicy::lru_touch(Entry* entry) {
+  switch (entry->lru_segment) {
+  case LRU_SEGMENT_PROBATION:
+    // second hit: promote to the protected segment
+    m_probation_lru.lru_remove(entry);
+    m_protected_lru.lru_insert_top(entry);
+    entry->lru_segment = LRU_SEGMENT_PROTECTED;
+    break;
+  case LRU_SEGMENT_PROTECTED:
+    m_protected_lru.lru_touch(entry);
+    return;
+  default:
+    // already picked for eviction
+    return;
+  }
+
+  // demote the coldest protected entries back to probation
+  uint64_t max_protected = get_promoted_entry_num() * PROTECTED_RATIO;
+  while (m_protected_lru.lru_get_size() > max_protected) {
+    Entry* demoted = reinterpret_cast<Entry*>(m_protected_lru.lru_expire());
+    if (demoted == nullptr) {
+      break;
+    }
+    m_probation_lru.lru_insert_top(demoted);
+    demoted->lru_segment = LRU_SEGMENT_PROBATION;
+  }
+}
+
+SimplePolicy::Entry* SimplePolicy::lru_get_next_expire() {
+  Entry* entry = reinterpret_cast<Entry*>(
+    m_probation_lru.lru_get_next_expire());
+  if (entry == nullptr) {
+    entry = reinterpret_cast<Entry*>(m_protected_lru.lru_get_next_expire());
+  }
+  return entry;
+}
+
 }  // namespace immutable_obj_cache
 }  // namespace ceph
@@ -35,9 +35,25 @@ class SimplePolicy : public Policy {
   uint64_t get_free_size();
   uint64_t get_promoting_entry_num();
   uint64_t get_promoted_entry_num();
+  uint64_t get_protected_entry_num();
   std::string get_evict_entry();
 
  private:
+  /*
+   * Promoted entries start out in the probation segment and only move to
+   * the protected segment once they are hit again, so that objects which
+   * are read just once (e.g. a full image scan) are evicted before the
+   * working set shared by many clones.
+   */
+  enum lru_segment_t {
+    LRU_SEGMENT_NONE = 0,
+    LRU_SEGMENT_PROBATION,
+    LRU_SEGMENT_PROTECTED,
+  };
+
+  // max share of promoted entries kept in the protected segment
+  static constexpr double PROTECTED_RATIO = 0.8;
+
   cache_status_t alloc_entry(std::string file_name);
 
   class Entry : public LRUObject {
@@ -46,8 +62,13 @@ class SimplePolicy : public Policy {
     Entry() : status(OBJ_CACHE_NONE) {}
     std::string file_name;
     uint64_t size;
+    lru_segment_t lru_segment = LRU_SEGMENT_NONE;
   };
 
+  void lru_remove(Entry* entry);
+  void lru_touch(Entry* entry);
+  Entry* lru_get_next_expire();
+
   CephContext* cct;
   double m_watermark;
   uint64_t m_max_inflight_ops;
@@ -60,7 +81,12 @@ class SimplePolicy : public Policy {
 
   std::atomic<uint64_t> m_cache_size;
 
-  LRU m_promoted_lru;
+  // lookups only hold m_cache_map_lock for read, so LRU updates from
+  // concurrent hits are serialized separately
+  ceph::mutex m_lru_lock =
+    ceph::make_mutex("rbd::cache::SimplePolicy::m_lru_lock");
+  LRU m_probation_lru;
+  LRU m_protected_lru;
 };
 
 }  // namespace immutable_obj_cache
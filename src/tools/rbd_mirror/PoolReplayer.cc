@@ -1025,6 +1025,9 @@ void PoolReplayer<I>::handle_pre_release_leader(Context *on_finish) {
         m_service_daemon->remove_attribute(m_local_pool_id,
                                            SERVICE_DAEMON_LEADER_KEY);
 
+        m_instance_ids.clear();
+        update_image_sync_scale();
+
         auto cct = reinterpret_cast<CephContext *>(m_local_io_ctx.cct());
         auto gather_ctx = new C_Gather(cct, on_finish);
 
@@ -1063,6 +1066,9 @@ void PoolReplayer<I>::handle_instances_added(
     return;
   }
 
+  m_instance_ids.insert(instance_ids.begin(), instance_ids.end());
+  update_image_sync_scale();
+
   m_default_namespace_replayer->handle_instances_added(instance_ids);
 
   for (auto &it : m_namespace_replayers) {
@@ -1080,6 +1086,11 @@ void PoolReplayer<I>::handle_instances_removed(
     return;
   }
 
+  for (auto &instance_id : instance_ids) {
+    m_instance_ids.erase(instance_id);
+  }
+  update_image_sync_scale();
+
   m_default_namespace_replayer->handle_instances_removed(instance_ids);
 
   for (auto &it : m_namespace_replayers) {
@@ -1087,6 +1098,28 @@ void PoolReplayer<I>::handle_instances_removed(
   }
 }
 
+template <typename I>
+void PoolReplayer<I>::update_image_sync_scale() {
+  ceph_assert(ceph_mutex_is_locked(m_lock));
+
+  if (!m_image_sync_throttler) {
+    return;
+  }
+
+  // image syncs are granted by the leader but executed by the instance
+  // owning the image, so allow the pool-wide limit to grow with the number
+  // of rbd-mirror instances
+  auto cct = reinterpret_cast<CephContext *>(m_local_io_ctx.cct());
+  uint32_t scale = 1;
+  if (cct->_conf.get_val<bool>(
+        "rbd_mirror_concurrent_image_syncs_per_instance")) {
+    scale = std::max<size_t>(1, m_instance_ids.size());
+  }
+
+  dout(10) << "scale=" << scale << dendl;
+  m_image_sync_throttler->set_scale(scale);
+}
+
 template <typename I>
 void PoolReplayer<I>::handle_remote_pool_meta_updated(
     const RemotePoolMeta& remote_pool_meta) {
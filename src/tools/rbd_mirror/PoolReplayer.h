@@ -119,6 +119,7 @@ private:
 
   void handle_instances_added(const std::vector<std::string> &instance_ids);
   void handle_instances_removed(const std::vector<std::string> &instance_ids);
+  void update_image_sync_scale();
 
   // sync version, executed in the caller thread
   template <typename L>
@@ -228,6 +229,7 @@ private:
   service_daemon::CalloutId m_callout_id = service_daemon::CALLOUT_ID_NONE;
 
   bool m_leader = false;
+  std::set<std::string> m_instance_ids;
   bool m_namespace_replayers_locked = false;
   Context *m_on_namespace_replayers_unlocked = nullptr;
 
@@ -33,7 +33,8 @@ Throttler<I>::Throttler(CephContext *cct, const std::string &config_key)
     m_config_keys{m_config_key.c_str(), nullptr},
     m_lock(ceph::make_mutex(
       librbd::util::unique_lock_name("rbd::mirror::Throttler", this))),
-    m_max_concurrent_ops(cct->_conf.get_val<uint64_t>(m_config_key)) {
+    m_config_max_concurrent_ops(cct->_conf.get_val<uint64_t>(m_config_key)),
+    m_max_concurrent_ops(m_config_max_concurrent_ops) {
   dout(20) << m_config_key << "=" << m_max_concurrent_ops << dendl;
   m_cct->_conf.add_observer(this);
 }
@@ -186,7 +187,8 @@ void Throttler<I>::set_max_concurrent_ops(uint32_t max) {
   std::list<Context *> ops;
   {
     std::lock_guard locker{m_lock};
-    m_max_concurrent_ops = max;
+    m_config_max_concurrent_ops = max;
+    m_max_concurrent_ops = max * m_scale;
 
     // Start waiting ops in the case of available free slots
     while ((m_max_concurrent_ops == 0 ||
@@ -210,6 +212,20 @@ void Throttler<I>::set_max_concurrent_ops(uint32_t max) {
   }
 }
 
+template <typename I>
+void Throttler<I>::set_scale(uint32_t scale) {
+  dout(20) << "scale=" << scale << dendl;
+
+  uint32_t max;
+  {
+    std::lock_guard locker{m_lock};
+    m_scale = std::max<uint32_t>(1, scale);
+    max = m_config_max_concurrent_ops;
+  }
+
+  set_max_concurrent_ops(max);
+}
+
 template <typename I>
 void Throttler<I>::print_status(ceph::Formatter *f) {
   dout(20) << dendl;
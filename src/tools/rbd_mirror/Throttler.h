@@ -40,6 +40,7 @@ public:
   ~Throttler() override;
 
   void set_max_concurrent_ops(uint32_t max);
+  void set_scale(uint32_t scale);
   void start_op(const std::string &ns, const std::string &id,
                 Context *on_start);
   bool cancel_op(const std::string &ns, const std::string &id);
@@ -56,6 +57,8 @@ private:
   mutable const char* m_config_keys[2];
 
   ceph::mutex m_lock;
+  uint32_t m_config_max_concurrent_ops;
+  uint32_t m_scale = 1;
   uint32_t m_max_concurrent_ops;
   std::list<Id> m_queue;
   std::map<Id, Context *> m_queued_ops;
@@ -46,9 +46,11 @@
 
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <regex>
+#include <vector>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/lexical_cast.hpp>
 
@@ -100,6 +102,7 @@ struct Config {
   int max_part = 255;
   int io_timeout = -1;
   int reattach_timeout = 30;
+  int num_connections = 1;
 
   bool exclusive = false;
   bool notrim = false;
@@ -154,6 +157,8 @@ static void usage()
             << "  --encryption-passphrase-file  Path of file containing passphrase for unlocking image encryption\n"
             << "  --exclusive                   Forbid writes by other clients\n"
             << "  --notrim                      Turn off trim/discard\n"
+            << "  --num-connections <count>     Number of nbd connections (queues)\n"
+            << "                                (requires --try-netlink, default: " << Config().num_connections << ")\n"
             << "  --io-timeout <sec>            Set nbd IO timeout\n"
             << "  --max_part <limit>            Override for module param max_part\n"
             << "  --nbds_max <limit>            Override for module param nbds_max\n"
@@ -178,6 +183,10 @@ static EventSocket terminate_event_sock;
 
 #define RBD_NBD_BLKSIZE 512UL
 
+#ifndef NBD_FLAG_CAN_MULTI_CONN
+#define NBD_FLAG_CAN_MULTI_CONN (1 << 8)
+#endif
+
 #define HELP_INFO 1
 #define VERSION_INFO 2
 
@@ -196,19 +205,65 @@ public:
   uint64_t quiesce_watch_handle = 0;
 
 private:
-  int fd;
   librbd::Image &image;
   Config *cfg;
 
+  class ThreadHelper : public Thread
+  {
+  private:
+    std::function<void()> func;
+  public:
+    ThreadHelper(std::function<void()> _func)
+      : func(std::move(_func))
+    {}
+  protected:
+    void* entry() override
+    {
+      func();
+      return NULL;
+    }
+  };
+
+  /*
+   * Each socket handed over to the kernel is served by its own reader
+   * and writer threads and keeps its own in-flight IO lists, so that
+   * multi-connection devices scale with the number of queues.
+   */
+  struct IOContext;
+  struct Connection
+  {
+    size_t index;
+    int fd;
+
+    ceph::mutex lock = ceph::make_mutex("NBDServer::Connection::Locker");
+    ceph::condition_variable cond;
+    xlist<IOContext*> io_pending;
+    xlist<IOContext*> io_finished;
+    bool terminated = false;
+
+    ThreadHelper reader_thread;
+    ThreadHelper writer_thread;
+
+    Connection(NBDServer *server, size_t index, int fd)
+      : index(index)
+      , fd(fd)
+      , reader_thread([server, this] { server->reader_entry(this); })
+      , writer_thread([server, this] { server->writer_entry(this); })
+    {}
+  };
+
+  std::vector<std::unique_ptr<Connection>> connections;
+
 public:
-  NBDServer(int fd, librbd::Image& image, Config *cfg)
-    : fd(fd)
-    , image(image)
+  NBDServer(const std::vector<int> &fds, librbd::Image& image, Config *cfg)
+    : image(image)
     , cfg(cfg)
-    , reader_thread(*this, &NBDServer::reader_entry)
-    , writer_thread(*this, &NBDServer::writer_entry)
-    , quiesce_thread(*this, &NBDServer::quiesce_entry)
+    , quiesce_thread([this] { quiesce_entry(); })
   {
+    for (size_t i = 0; i < fds.size(); i++) {
+      connections.push_back(std::make_unique<Connection>(this, i, fds[i]));
+    }
+
     std::vector<librbd::config_option_t> options;
     image.config_list(&options);
     for (auto &option : options) {
@@ -226,17 +281,22 @@ public:
   }
 
 private:
+  // max number of replies coalesced into a single writev
+  static const size_t MAX_REPLY_BATCH = 64;
+
   int terminate_event_fd = -1;
   ceph::mutex disconnect_lock =
     ceph::make_mutex("NBDServer::DisconnectLocker");
   ceph::condition_variable disconnect_cond;
   std::atomic<bool> terminated = { false };
+  std::atomic<bool> disconnecting = { false };
   std::atomic<bool> allow_internal_flush = { false };
 
   struct IOContext
   {
     xlist<IOContext*>::item item;
     NBDServer *server = nullptr;
+    Connection *conn = nullptr;
     struct nbd_request request;
     struct nbd_reply reply;
     bufferlist data;
@@ -251,60 +311,62 @@ private:
 
   ceph::mutex lock = ceph::make_mutex("NBDServer::Locker");
   ceph::condition_variable cond;
-  xlist<IOContext*> io_pending;
-  xlist<IOContext*> io_finished;
 
   void io_start(IOContext *ctx)
   {
-    std::lock_guard l{lock};
-    io_pending.push_back(&ctx->item);
+    Connection *conn = ctx->conn;
+    std::lock_guard l{conn->lock};
+    conn->io_pending.push_back(&ctx->item);
   }
 
   void io_finish(IOContext *ctx)
   {
-    std::lock_guard l{lock};
+    Connection *conn = ctx->conn;
+    std::lock_guard l{conn->lock};
     ceph_assert(ctx->item.is_on_list());
     ctx->item.remove_myself();
-    io_finished.push_back(&ctx->item);
-    cond.notify_all();
+    conn->io_finished.push_back(&ctx->item);
+    conn->cond.notify_all();
   }
 
-  IOContext *wait_io_finish()
+  bool wait_io_finish(Connection *conn,
+                      std::vector<std::unique_ptr<IOContext>> *ctxs)
   {
-    std::unique_lock l{lock};
-    cond.wait(l, [this] {
-                   return !io_finished.empty() ||
-                          (io_pending.empty() && terminated);
-                 });
-
-    if (io_finished.empty())
-      return NULL;
-
-    IOContext *ret = io_finished.front();
-    io_finished.pop_front();
+    std::unique_lock l{conn->lock};
+    conn->cond.wait(l, [conn] {
+                         return !conn->io_finished.empty() ||
+                                (conn->io_pending.empty() && conn->terminated);
+                       });
+
+    while (!conn->io_finished.empty() && ctxs->size() < MAX_REPLY_BATCH) {
+      ctxs->emplace_back(conn->io_finished.front());
+      conn->io_finished.pop_front();
+    }
 
-    return ret;
+    return !ctxs->empty();
   }
 
-  void wait_clean()
+  void wait_clean(Connection *conn)
   {
-    std::unique_lock l{lock};
-    cond.wait(l, [this] { return io_pending.empty(); });
+    std::unique_lock l{conn->lock};
+    conn->cond.wait(l, [conn] { return conn->io_pending.empty(); });
 
-    while(!io_finished.empty()) {
-      std::unique_ptr<IOContext> free_ctx(io_finished.front());
-      io_finished.pop_front();
+    while(!conn->io_finished.empty()) {
+      std::unique_ptr<IOContext> free_ctx(conn->io_finished.front());
+      conn->io_finished.pop_front();
     }
   }
 
   void assert_clean()
   {
-    std::unique_lock l{lock};
+    for (auto &conn : connections) {
+      std::unique_lock l{conn->lock};
 
-    ceph_assert(!reader_thread.is_started());
-    ceph_assert(!writer_thread.is_started());
-    ceph_assert(io_pending.empty());
-    ceph_assert(io_finished.empty());
+      ceph_assert(!conn->reader_thread.is_started());
+      ceph_assert(!conn->writer_thread.is_started());
+      ceph_assert(conn->io_pending.empty());
+      ceph_assert(conn->io_finished.empty());
+    }
   }
 
   static void aio_callback(librbd::completion_t cb, void *arg)
@@ -342,11 +404,11 @@ private:
     aio_completion->release();
   }
 
-  void reader_entry()
+  void reader_entry(Connection *conn)
   {
     struct pollfd poll_fds[2];
     memset(poll_fds, 0, sizeof(struct pollfd) * 2);
-    poll_fds[0].fd = fd;
+    poll_fds[0].fd = conn->fd;
     poll_fds[0].events = POLLIN;
     poll_fds[1].fd = terminate_event_fd;
     poll_fds[1].events = POLLIN;
@@ -354,8 +416,10 @@ private:
     while (true) {
       std::unique_ptr<IOContext> ctx(new IOContext());
       ctx->server = this;
+      ctx->conn = conn;
 
-      dout(20) << __func__ << ": waiting for nbd request" << dendl;
+      dout(20) << __func__ << ": " << conn->index
+               << ": waiting for nbd request" << dendl;
 
       int r = poll(poll_fds, 2, -1);
       if (r == -1) {
@@ -368,7 +432,8 @@ private:
       }
 
       if ((poll_fds[1].revents & POLLIN) != 0) {
-        dout(0) << __func__ << ": terminate received" << dendl;
+        dout(0) << __func__ << ": " << conn->index << ": terminate received"
+                << dendl;
         goto signal;
       }
 
@@ -377,7 +442,7 @@ private:
         continue;
       }
 
-      r = safe_read_exact(fd, &ctx->request, sizeof(struct nbd_request));
+      r = safe_read_exact(conn->fd, &ctx->request, sizeof(struct nbd_request));
       if (r < 0) {
 	derr << "failed to read nbd request header: " << cpp_strerror(r)
 	     << dendl;
@@ -408,7 +473,7 @@ private:
           goto signal;
         case NBD_CMD_WRITE:
           bufferptr ptr(ctx->request.len);
-	  r = safe_read_exact(fd, ptr.c_str(), ctx->request.len);
+	  r = safe_read_exact(conn->fd, ptr.c_str(), ctx->request.len);
           if (r < 0) {
 	    derr << *ctx << ": failed to read nbd request data: "
 		 << cpp_strerror(r) << dendl;
@@ -443,57 +508,75 @@ private:
       }
     }
 error:
-    {
+    // the disconnect tears down every socket of the device, so only the
+    // first failing connection needs to request it
+    if (!disconnecting.exchange(true)) {
       int r = netlink_disconnect(nbd_index);
       if (r == 1) {
         ioctl(nbd, NBD_DISCONNECT);
       }
     }
 signal:
-    std::lock_guard l{lock};
-    terminated = true;
-    cond.notify_all();
+    {
+      std::lock_guard l{conn->lock};
+      conn->terminated = true;
+      conn->cond.notify_all();
+    }
+    {
+      std::lock_guard l{lock};
+      terminated = true;
+      cond.notify_all();
+    }
 
     std::lock_guard disconnect_l{disconnect_lock};
     disconnect_cond.notify_all();
 
-    dout(20) << __func__ << ": terminated" << dendl;
+    dout(20) << __func__ << ": " << conn->index << ": terminated" << dendl;
   }
 
-  void writer_entry()
+  void writer_entry(Connection *conn)
   {
+    std::vector<std::unique_ptr<IOContext>> ctxs;
+    ctxs.reserve(MAX_REPLY_BATCH);
+
     while (true) {
-      dout(20) << __func__ << ": waiting for io request" << dendl;
-      std::unique_ptr<IOContext> ctx(wait_io_finish());
-      if (!ctx) {
+      dout(20) << __func__ << ": " << conn->index
+               << ": waiting for io request" << dendl;
+      ctxs.clear();
+      if (!wait_io_finish(conn, &ctxs)) {
 	dout(20) << __func__ << ": no io requests, terminating" << dendl;
         goto done;
       }
 
-      dout(20) << __func__ << ": got: " << *ctx << dendl;
+      // coalesce all replies that are ready into a single writev
+      bufferlist bl;
+      for (auto &ctx : ctxs) {
+        dout(20) << __func__ << ": got: " << *ctx << dendl;
+
+        bl.append(reinterpret_cast<const char *>(&ctx->reply),
+                  sizeof(struct nbd_reply));
+        if (ctx->command == NBD_CMD_READ && ctx->reply.error == htonl(0)) {
+          bl.claim_append(ctx->data);
+        }
+      }
 
-      int r = safe_write(fd, &ctx->reply, sizeof(struct nbd_reply));
+      int r = bl.write_fd(conn->fd);
       if (r < 0) {
-	derr << *ctx << ": failed to write reply header: " << cpp_strerror(r)
-	     << dendl;
+	derr << __func__ << ": " << conn->index << ": failed to write "
+	     << ctxs.size() << " replies: " << cpp_strerror(r) << dendl;
         goto error;
       }
-      if (ctx->command == NBD_CMD_READ && ctx->reply.error == htonl(0)) {
-	r = ctx->data.write_fd(fd);
-        if (r < 0) {
-	  derr << *ctx << ": failed to write replay data: " << cpp_strerror(r)
-	       << dendl;
-          goto error;
-	}
+      for (auto &ctx : ctxs) {
+        dout(20) << *ctx << ": finish" << dendl;
       }
-      dout(20) << *ctx << ": finish" << dendl;
     }
   error:
-    wait_clean();
+    ctxs.clear();
+    wait_clean(conn);
   done:
-    ::shutdown(fd, SHUT_RDWR);
+    ::shutdown(conn->fd, SHUT_RDWR);
 
-    dout(20) << __func__ << ": terminated" << dendl;
+    dout(20) << __func__ << ": " << conn->index << ": terminated" << dendl;
   }
 
   bool wait_quiesce() {
@@ -571,25 +654,7 @@ signal:
     dout(20) << __func__ << ": terminated" << dendl;
   }
 
-  class ThreadHelper : public Thread
-  {
-  public:
-    typedef void (NBDServer::*entry_func)();
-  private:
-    NBDServer &server;
-    entry_func func;
-  public:
-    ThreadHelper(NBDServer &_server, entry_func _func)
-      :server(_server)
-      ,func(_func)
-    {}
-  protected:
-    void* entry() override
-    {
-      (server.*func)();
-      return NULL;
-    }
-  } reader_thread, writer_thread, quiesce_thread;
+  ThreadHelper quiesce_thread;
 
   bool started = false;
   bool quiesce = false;
@@ -608,8 +673,12 @@ public:
                                         EVENT_SOCKET_TYPE_EVENTFD);
       ceph_assert(r >= 0);
 
-      reader_thread.create("rbd_reader");
-      writer_thread.create("rbd_writer");
+      for (auto &conn : connections) {
+        auto suffix = connections.size() > 1 ?
+          "_" + stringify(conn->index) : std::string();
+        conn->reader_thread.create(("rbd_reader" + suffix).c_str());
+        conn->writer_thread.create(("rbd_writer" + suffix).c_str());
+      }
       if (cfg->quiesce) {
         quiesce_thread.create("rbd_quiesce");
       }
@@ -654,8 +723,10 @@ public:
 
       terminate_event_sock.notify();
 
-      reader_thread.join();
-      writer_thread.join();
+      for (auto &conn : connections) {
+        conn->reader_thread.join();
+        conn->writer_thread.join();
+      }
       if (cfg->quiesce) {
         quiesce_thread.join();
       }
@@ -1278,8 +1349,9 @@ static int netlink_connect_cb(struct nl_msg *msg, void *arg)
   return NL_OK;
 }
 
-static int netlink_connect(Config *cfg, struct nl_sock *sock, int nl_id, int fd,
-                           uint64_t size, uint64_t flags, bool reconnect)
+static int netlink_connect(Config *cfg, struct nl_sock *sock, int nl_id,
+                           const std::vector<int> &fds, uint64_t size,
+                           uint64_t flags, bool reconnect)
 {
   struct nlattr *sock_attr;
   struct nlattr *sock_opt;
@@ -1332,14 +1404,16 @@ static int netlink_connect(Config *cfg, struct nl_sock *sock, int nl_id, int fd,
     goto free_msg;
   }
 
-  sock_opt = nla_nest_start(msg, NBD_SOCK_ITEM);
-  if (!sock_opt) {
-    cerr << "rbd-nbd: Could not init sock in netlink message." << std::endl;
-    goto free_msg;
-  }
+  for (auto fd : fds) {
+    sock_opt = nla_nest_start(msg, NBD_SOCK_ITEM);
+    if (!sock_opt) {
+      cerr << "rbd-nbd: Could not init sock in netlink message." << std::endl;
+      goto free_msg;
+    }
 
-  NLA_PUT_U32(msg, NBD_SOCK_FD, fd);
-  nla_nest_end(msg, sock_opt);
+    NLA_PUT_U32(msg, NBD_SOCK_FD, fd);
+    nla_nest_end(msg, sock_opt);
+  }
   nla_nest_end(msg, sock_attr);
 
   ret = nl_send_sync(sock, msg);
@@ -1358,8 +1432,8 @@ free_msg:
   return -EIO;
 }
 
-static int try_netlink_setup(Config *cfg, int fd, uint64_t size, uint64_t flags,
-                             bool reconnect)
+static int try_netlink_setup(Config *cfg, const std::vector<int> &fds,
+                             uint64_t size, uint64_t flags, bool reconnect)
 {
   struct nl_sock *sock;
   int nl_id, ret;
@@ -1373,7 +1447,7 @@ static int try_netlink_setup(Config *cfg, int fd, uint64_t size, uint64_t flags,
 
   dout(10) << "netlink interface supported." << dendl;
 
-  ret = netlink_connect(cfg, sock, nl_id, fd, size, flags, reconnect);
+  ret = netlink_connect(cfg, sock, nl_id, fds, size, flags, reconnect);
   netlink_cleanup(sock);
 
   if (ret != 0)
@@ -1429,11 +1503,12 @@ static void handle_signal(int signum)
   terminate_event_sock.notify();
 }
 
-static NBDServer *start_server(int fd, librbd::Image& image, Config *cfg)
+static NBDServer *start_server(const std::vector<int> &fds,
+                               librbd::Image& image, Config *cfg)
 {
   NBDServer *server;
 
-  server = new NBDServer(fd, image, cfg);
+  server = new NBDServer(fds, image, cfg);
   server->start();
 
   init_async_signal_handler();
@@ -1559,7 +1634,9 @@ static int do_map(int argc, const char *argv[], Config *cfg, bool reconnect)
   unsigned long blksize = RBD_NBD_BLKSIZE;
   bool use_netlink;
 
-  int fd[2];
+  // kernel and server ends of the socket pair backing each connection
+  std::vector<int> kernel_fds;
+  std::vector<int> server_fds;
 
   librbd::image_info_t info;
 
@@ -1600,11 +1677,23 @@ static int do_map(int argc, const char *argv[], Config *cfg, bool reconnect)
   common_init_finish(g_ceph_context);
   global_init_chdir(g_ceph_context);
 
-  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fd) == -1) {
-    r = -errno;
+  if (cfg->num_connections > 1 && !cfg->try_netlink && !reconnect) {
+    r = -EINVAL;
+    cerr << "rbd-nbd: multiple connections require the netlink interface"
+         << std::endl;
     goto close_ret;
   }
 
+  for (int i = 0; i < cfg->num_connections; i++) {
+    int fd[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fd) == -1) {
+      r = -errno;
+      goto close_fd;
+    }
+    kernel_fds.push_back(fd[0]);
+    server_fds.push_back(fd[1]);
+  }
+
   r = rados.init_with_context(g_ceph_context);
   if (r < 0)
     goto close_fd;
@@ -1697,6 +1786,9 @@ static int do_map(int argc, const char *argv[], Config *cfg, bool reconnect)
   if (!cfg->notrim) {
     flags |= NBD_FLAG_SEND_TRIM;
   }
+  if (cfg->num_connections > 1) {
+    flags |= NBD_FLAG_CAN_MULTI_CONN;
+  }
   if (!cfg->snapname.empty() || cfg->readonly) {
     flags |= NBD_FLAG_READ_ONLY;
     read_only = 1;
@@ -1715,11 +1807,11 @@ static int do_map(int argc, const char *argv[], Config *cfg, bool reconnect)
   if (r < 0)
     goto close_fd;
 
-  server = start_server(fd[1], image, cfg);
+  server = start_server(server_fds, image, cfg);
 
   use_netlink = cfg->try_netlink || reconnect;
   if (use_netlink) {
-    r = try_netlink_setup(cfg, fd[0], size, flags, reconnect);
+    r = try_netlink_setup(cfg, kernel_fds, size, flags, reconnect);
     if (r < 0) {
       goto free_server;
     } else if (r == 1) {
@@ -1728,7 +1820,13 @@ static int do_map(int argc, const char *argv[], Config *cfg, bool reconnect)
   }
 
   if (!use_netlink) {
-    r = try_ioctl_setup(cfg, fd[0], size, blksize, flags);
+    if (kernel_fds.size() > 1) {
+      r = -EINVAL;
+      cerr << "rbd-nbd: multiple connections require the netlink interface"
+           << std::endl;
+      goto free_server;
+    }
+    r = try_ioctl_setup(cfg, kernel_fds[0], size, blksize, flags);
     if (r < 0)
       goto free_server;
   }
@@ -1788,8 +1886,12 @@ close_nbd:
 free_server:
   delete server;
 close_fd:
-  close(fd[0]);
-  close(fd[1]);
+  for (auto fd : kernel_fds) {
+    close(fd);
+  }
+  for (auto fd : server_fds) {
+    close(fd);
+  }
 close_ret:
   image.close();
   io_ctx.close();
@@ -2035,6 +2137,16 @@ static int parse_args(vector<const char*>& args, std::ostream *err_msg,
         *err_msg << "rbd-nbd: Invalid argument for reattach-timeout!";
         return -EINVAL;
       }
+    } else if (ceph_argparse_witharg(args, i, &cfg->num_connections, err,
+                                     "--num-connections", (char *)NULL)) {
+      if (!err.str().empty()) {
+        *err_msg << "rbd-nbd: " << err.str();
+        return -EINVAL;
+      }
+      if (cfg->num_connections < 1) {
+        *err_msg << "rbd-nbd: Invalid argument for num-connections!";
+        return -EINVAL;
+      }
     } else if (ceph_argparse_flag(args, i, "--exclusive", (char *)NULL)) {
       cfg->exclusive = true;
     } else if (ceph_argparse_flag(args, i, "--notrim", (char *)NULL)) {